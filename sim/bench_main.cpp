@@ -0,0 +1,279 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Bus-traffic benchmark: runs every factory clock face through a simulated day and reports the
+// ring command (UART) and I2C traffic of normal mode.
+//
+// Usage: program [--baseline <file>] [--write-baseline <file>] [--tolerance <percent>] [--pic <revision>]
+//                [--baud <rate>]
+//   --baseline        Compare against a baseline, exit with 1 if any figure regressed by more
+//                     than the tolerance.
+//   --write-baseline  Write the measured figures as a new baseline.
+//   --tolerance       Allowed regression in percent (default 2).
+//   --pic             PIC firmware revision: full (default), nowrap, basic or silent, see
+//                     pic_ring.h.
+//                     The baseline is for the full revision.
+//   --baud            Fastest baud rate the PIC keeps up with (default 9600, the rate of a PIC
+//                     without the set baud command). The firmware negotiates the rate in
+//                     setup(), so the millisecond figures at 115200 show the gain of the set
+//                     baud command. A baseline is only compared at the rate it was written at.
+//
+// Each face starts at 23:59:59 on a freshly reset board with factory settings. The first tick
+// draws the whole face from scratch, as after a menu exit, and is reported on its own. The
+// following 86400 ticks cover 00:00:00 to 23:59:59 including every minute and hour rollover. A tick is all the traffic one pass of
+// loop() produces after the RTC has moved to the next second. The frames of the background
+// scrubber are left out of the ring figures and reported on their own as scrub bytes per day.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "board.h"
+#include "firmware.h"
+
+#define BENCH_TICKS           86400
+#define BENCH_BITS_PER_BYTE   10
+#define BENCH_IDLE_MILLIS     100
+//  RING_QUEUE_LOW of the firmware
+#define BENCH_QUEUE_LOW       1
+#define BENCH_METRICS         7
+
+struct BenchResult {
+  uint8_t faceBytes[4];
+  unsigned long baud;
+  double metrics[BENCH_METRICS];
+};
+
+//  Metric indexes, in the order they are printed and stored in the baseline.
+#define BENCH_RING_BYTES        0
+#define BENCH_WORST_TICK_BYTES  1
+#define BENCH_P99_TICK_MS       2
+#define BENCH_WORST_TICK_MS     3
+#define BENCH_I2C_BYTES         4
+#define BENCH_REDRAW_MS         5
+#define BENCH_SCRUB_BYTES       6
+
+static const char *metricNames[BENCH_METRICS] = {
+  "ring bytes/day", "worst tick bytes", "p99 tick ms", "worst tick ms", "I2C bytes/day", "redraw ms",
+  "scrub bytes/day"
+};
+
+//  Ring bytes the scrubber has written, counted as they go out of the low priority queue.
+static uint64_t ringScrubBytes = 0;
+
+static void countScrubByte(uint8_t data) {
+  if (ringQueueSending == BENCH_QUEUE_LOW) {
+    ringScrubBytes++;
+  }
+}
+
+//  Ring bytes written, without the scrubber's.
+static uint64_t drawnBytes() {
+  return simUartBytesWritten() - ringScrubBytes;
+}
+
+static SimBoard board;
+static uint8_t picFeatures = PIC_FEATURES_ALL;
+static unsigned long picBaudLimit = 9600;
+
+//  Nearest-rank percentile.
+static double percentile(std::vector<uint32_t> values, double fraction) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t rank = (size_t)ceil(fraction * values.size());
+  return values[rank > 0 ? rank - 1 : 0];
+}
+
+static void runFace(void *arg, void *output) {
+  int face = *(int *)arg;
+  BenchResult &result = *(BenchResult *)output;
+
+  board.powerOn();
+  ringScrubBytes = 0;
+  simSetUartWriteHook(countScrubByte);
+  board.loadFactorySettings(face);
+  board.pic.setFeatures(picFeatures);
+  board.pic.setBaudLimit(picBaudLimit);
+  board.pic.setRecording(false);
+  board.display.setRecording(false);
+
+  for (uint8_t r = 0; r < 4; r++) {
+    result.faceBytes[r] = simEeprom()[10 + face * 10 + r];
+  }
+
+  setup();
+
+  //  Set the clock after setup(), which takes a few seconds of fading in the display.
+  board.rtc.setDateTime(19, 12, 31, 3, 23, 59, 59);
+  board.rtc.setSkipToEdge(true);
+
+  result.baud = simUartBaud();
+  double msPerByte = BENCH_BITS_PER_BYTE * 1000.0 / result.baud;
+
+  //  Initial draw of the face at 23:59:59
+  uint64_t redrawStart = drawnBytes();
+  loop();
+  ringFrameFlushAndWait();
+  result.metrics[BENCH_REDRAW_MS] = (drawnBytes() - redrawStart) * msPerByte;
+
+  uint64_t startEdges = board.rtc.edges();
+  uint64_t startRingBytes = drawnBytes();
+  uint64_t startScrubBytes = ringScrubBytes;
+  uint64_t startI2cBytes = simI2cBytesTransferred();
+
+  std::vector<uint32_t> tickBytes;
+  tickBytes.reserve(BENCH_TICKS);
+
+  while (board.rtc.edges() - startEdges < BENCH_TICKS) {
+    uint64_t before = drawnBytes();
+    loop();
+    ringFrameFlushAndWait();
+    tickBytes.push_back((uint32_t)(drawnBytes() - before));
+
+    //  The RTC jumps to the next edge on every read, so give the link the idle part of the
+    //  second the scrubber sends in on the board
+    delay(BENCH_IDLE_MILLIS);
+  }
+
+  uint32_t worst = *std::max_element(tickBytes.begin(), tickBytes.end());
+
+  result.metrics[BENCH_RING_BYTES] = drawnBytes() - startRingBytes;
+  result.metrics[BENCH_SCRUB_BYTES] = ringScrubBytes - startScrubBytes;
+  result.metrics[BENCH_WORST_TICK_BYTES] = worst;
+  result.metrics[BENCH_P99_TICK_MS] = percentile(tickBytes, 0.99) * msPerByte;
+  result.metrics[BENCH_WORST_TICK_MS] = worst * msPerByte;
+  result.metrics[BENCH_I2C_BYTES] = simI2cBytesTransferred() - startI2cBytes;
+}
+
+static bool readBaseline(const char *path, unsigned long baud, BenchResult *baseline) {
+  FILE *in = fopen(path, "r");
+  if (in == nullptr) {
+    fprintf(stderr, "Cannot read baseline %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  int loaded = 0;
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    int face;
+    double m[BENCH_METRICS];
+    unsigned long lineBaud;
+    if (sscanf(line, "# Bus-traffic baseline, one simulated day per factory face at %lu baud", &lineBaud) == 1 &&
+        lineBaud != baud) {
+      fprintf(stderr, "Baseline %s is for %lu baud, not %lu\n", path, lineBaud, baud);
+      fclose(in);
+      return false;
+    }
+    if (line[0] == '#') {
+      continue;
+    }
+    if (sscanf(line, "%d %lf %lf %lf %lf %lf %lf %lf", &face, &m[0], &m[1], &m[2], &m[3], &m[4], &m[5], &m[6]) ==
+            1 + BENCH_METRICS &&
+        face >= 0 && face < SIM_FACTORY_FACES) {
+      memcpy(baseline[face].metrics, m, sizeof(m));
+      loaded++;
+    }
+  }
+  fclose(in);
+
+  if (loaded != SIM_FACTORY_FACES) {
+    fprintf(stderr, "Baseline %s has %d of %d faces\n", path, loaded, SIM_FACTORY_FACES);
+    return false;
+  }
+  return true;
+}
+
+static bool writeBaseline(const char *path, const BenchResult *results) {
+  FILE *out = fopen(path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "Cannot write baseline %s\n", path);
+    return false;
+  }
+
+  fprintf(out, "# Bus-traffic baseline, one simulated day per factory face at %lu baud.\n", results[0].baud);
+  fprintf(out, "# face ring_bytes worst_tick_bytes p99_tick_ms worst_tick_ms i2c_bytes redraw_ms scrub_bytes\n");
+  for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+    const double *m = results[face].metrics;
+    fprintf(out, "%d %.0f %.0f %.3f %.3f %.0f %.3f %.0f\n", face, m[0], m[1], m[2], m[3], m[4], m[5], m[6]);
+  }
+  fclose(out);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *baselinePath = nullptr;
+  const char *writePath = nullptr;
+  double tolerance = 2.0;
+
+  for (int r = 1; r < argc; r++) {
+    if (strcmp(argv[r], "--baseline") == 0 && r + 1 < argc) {
+      baselinePath = argv[++r];
+    } else if (strcmp(argv[r], "--write-baseline") == 0 && r + 1 < argc) {
+      writePath = argv[++r];
+    } else if (strcmp(argv[r], "--tolerance") == 0 && r + 1 < argc) {
+      tolerance = atof(argv[++r]);
+    } else if (strcmp(argv[r], "--pic") == 0 && r + 1 < argc && PicRingEmulator::parseFeatures(argv[r + 1], picFeatures)) {
+      r++;
+    } else if (strcmp(argv[r], "--baud") == 0 && r + 1 < argc && PicRingEmulator::parseBaud(argv[r + 1], picBaudLimit)) {
+      r++;
+    } else {
+      fprintf(stderr, "Usage: %s [--baseline <file>] [--write-baseline <file>] [--tolerance <percent>] [--pic <revision>]\n"
+                      "          [--baud <rate>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  BenchResult results[SIM_FACTORY_FACES];
+  for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+    if (!simRunIsolated(runFace, &face, &results[face], sizeof(results[face]))) {
+      fprintf(stderr, "Simulation of face %d failed\n", face);
+      return 1;
+    }
+  }
+
+  printf("Ring link at %lu baud\n", results[0].baud);
+  printf("Face  Colors       %16s %16s %16s %16s %16s %16s %16s\n",
+         metricNames[0], metricNames[1], metricNames[2], metricNames[3], metricNames[4], metricNames[5],
+         metricNames[6]);
+  for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+    const BenchResult &result = results[face];
+    printf("%4d  %02X %02X %02X %02X  %16.0f %16.0f %16.3f %16.3f %16.0f %16.3f %16.0f\n", face,
+           result.faceBytes[0], result.faceBytes[1], result.faceBytes[2], result.faceBytes[3],
+           result.metrics[0], result.metrics[1], result.metrics[2], result.metrics[3], result.metrics[4],
+           result.metrics[5], result.metrics[6]);
+  }
+
+  int status = 0;
+
+  if (baselinePath != nullptr) {
+    BenchResult baseline[SIM_FACTORY_FACES];
+    if (!readBaseline(baselinePath, results[0].baud, baseline)) {
+      return 1;
+    }
+
+    for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+      for (int m = 0; m < BENCH_METRICS; m++) {
+        double limit = baseline[face].metrics[m] * (1.0 + tolerance / 100.0) + 0.0005;
+        if (results[face].metrics[m] > limit) {
+          printf("REGRESSION face %d %s: %.3f, baseline %.3f\n",
+                 face, metricNames[m], results[face].metrics[m], baseline[face].metrics[m]);
+          status = 1;
+        }
+      }
+    }
+    printf(status == 0 ? "Within %.1f%% of baseline\n" : "Regressed more than %.1f%% from baseline\n", tolerance);
+  }
+
+  if (writePath != nullptr && !writeBaseline(writePath, results)) {
+    return 1;
+  }
+  return status;
+}
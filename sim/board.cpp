@@ -0,0 +1,171 @@
+//-------------------------------------------------------------------------------------------------
+//
+// The emulated ClockOS board, see board.h.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "board.h"
+#include "firmware.h"
+#include "sim_hal.h"
+
+void SimBoard::powerOn() {
+  simReset();
+
+  pic.reset();
+  display.reset();
+  rtc.reset();
+
+  simAttachUart(&pic);
+  simAttachI2c(SIM_HT16K33_I2C_ADDRESS, &display);
+  simAttachI2c(SIM_DS1307_I2C_ADDRESS, &rtc);
+}
+
+void SimBoard::loadFactorySettings(int face) {
+  writeFactorySettingsToEeprom();
+  if (face >= 0) {
+    simEeprom()[0] = face;
+  }
+}
+
+bool simRunIsolated(void (*run)(void *arg, void *result), void *arg, void *result, size_t size) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    close(fds[0]);
+    run(arg, result);
+    const char *data = (const char *)result;
+    size_t written = 0;
+    while (written < size) {
+      ssize_t n = write(fds[1], data + written, size - written);
+      if (n <= 0) {
+        _exit(1);
+      }
+      written += n;
+    }
+    close(fds[1]);
+    _exit(0);
+  }
+
+  close(fds[1]);
+  char *data = (char *)result;
+  size_t received = 0;
+  while (received < size) {
+    ssize_t n = read(fds[0], data + received, size - received);
+    if (n <= 0) {
+      break;
+    }
+    received += n;
+  }
+  close(fds[0]);
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return received == size && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//  Queue state shared by the workers of simRunQueue(), followed by the results.
+struct SimQueue {
+  int next;
+  int finished;
+  int failed;
+};
+
+struct SimQueueJob {
+  void (*run)(int job, void *result);
+  int job;
+};
+
+static void runQueueJob(void *arg, void *result) {
+  const SimQueueJob &job = *(const SimQueueJob *)arg;
+  job.run(job.job, result);
+}
+
+static void runQueueWorker(SimQueue *queue, int count, void (*run)(int job, void *result), char *results,
+                           size_t size) {
+  char *result = (char *)malloc(size);
+  for (;;) {
+    int job = __sync_fetch_and_add(&queue->next, 1);
+    if (job >= count) {
+      break;
+    }
+    SimQueueJob arg = { run, job };
+    memset(result, 0, size);
+    if (simRunIsolated(runQueueJob, &arg, result, size)) {
+      memcpy(results + job * size, result, size);
+    } else {
+      __sync_fetch_and_add(&queue->failed, 1);
+    }
+    __sync_fetch_and_add(&queue->finished, 1);
+  }
+  free(result);
+}
+
+int simRunQueue(int count, int workers, void (*run)(int job, void *result), void *results, size_t size,
+                bool progress) {
+  size_t shared = sizeof(SimQueue) + count * size;
+  void *memory = mmap(nullptr, shared, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return count;
+  }
+  SimQueue *queue = (SimQueue *)memory;
+  char *sharedResults = (char *)memory + sizeof(SimQueue);
+  memset(memory, 0, shared);
+
+  if (workers > count) {
+    workers = count;
+  }
+  int running = 0;
+  for (int r = 0; r < workers; r++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      runQueueWorker(queue, count, run, sharedResults, size);
+      _exit(0);
+    }
+    if (pid > 0) {
+      running++;
+    }
+  }
+
+  int reported = -1;
+  while (running > 0) {
+    int status;
+    pid_t pid = waitpid(-1, &status, progress ? WNOHANG : 0);
+    if (pid > 0) {
+      running--;
+    } else if (pid < 0) {
+      break;
+    } else {
+      usleep(200000);
+    }
+    if (progress && queue->finished != reported) {
+      reported = queue->finished;
+      fprintf(stderr, "\r%d of %d jobs done", reported, count);
+    }
+  }
+  if (progress) {
+    fprintf(stderr, "\n");
+  }
+
+  //  Jobs never taken because workers died count as failed too.
+  int failed = queue->failed + (count - queue->finished);
+  memcpy(results, sharedResults, count * size);
+  munmap(memory, shared);
+  return failed;
+}
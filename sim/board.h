@@ -0,0 +1,54 @@
+//-------------------------------------------------------------------------------------------------
+//
+// The emulated ClockOS board: PIC ring controller on the UART, HT16K33 display and DS1307 RTC
+// on I2C, wired to the simulator HAL the same way as on the real board.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_BOARD_H
+#define CLOCKOS_SIM_BOARD_H
+
+#include <stddef.h>
+
+#include "pic_ring.h"
+#include "ht16k33.h"
+#include "ds1307.h"
+
+#define SIM_HT16K33_I2C_ADDRESS 0x70
+#define SIM_DS1307_I2C_ADDRESS  0x68
+
+//  Number of clock faces in DEFAULT_FACTORY_COLORS.
+#define SIM_FACTORY_FACES 10
+
+class SimBoard {
+  public:
+    //  Resets the HAL and all peripherals and attaches them. The EEPROM is erased and the RTC
+    //  is halted until setDateTime() is called on it.
+    void powerOn();
+
+    //  Writes the factory settings to EEPROM with the given face selected (-1 keeps face 0).
+    void loadFactorySettings(int face);
+
+    PicRingEmulator pic;
+    Ht16k33Emulator display;
+    Ds1307Emulator rtc;
+};
+
+//  Runs a simulation in a child process forked from this one and copies its result back.
+//
+//  The firmware keeps its state in globals that are only initialised at program start, so a
+//  tool that runs the firmware more than once must not call setup()/loop() in its own process
+//  and run every simulation through here instead. Returns false if the child failed.
+bool simRunIsolated(void (*run)(void *arg, void *result), void *arg, void *result, size_t size);
+
+//  Runs jobs 0 to count - 1 on a pool of worker processes and stores the result of job j at
+//  results + j * size.
+//
+//  The workers take the next job from a queue shared between them, so long and short jobs
+//  balance out, and run every job through simRunIsolated(). With progress set the number of
+//  finished jobs is printed to stderr while waiting. Returns the number of jobs that failed
+//  to run, their results are left zeroed.
+int simRunQueue(int count, int workers, void (*run)(int job, void *result), void *results, size_t size,
+                bool progress);
+
+#endif
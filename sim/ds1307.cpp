@@ -0,0 +1,200 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the DS1307 real-time clock, see ds1307.h.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "ds1307.h"
+
+#define DS1307_NANOS_PER_SECOND 1e9
+
+static uint8_t toBcd(uint8_t value) {
+  return (value / 10 * 16) + (value % 10);
+}
+
+static uint8_t fromBcd(uint8_t value) {
+  return (value / 16 * 10) + (value % 16);
+}
+
+static uint8_t daysInMonth(uint8_t months, uint8_t years) {
+  static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (months == 2 && (years % 4) == 0) {
+    return 29;
+  }
+  return (months >= 1 && months <= 12) ? days[months - 1] : 31;
+}
+
+//  ====================================================================================
+
+Ds1307Emulator::Ds1307Emulator() {
+  timeScale = 1.0;
+  skipToEdge = false;
+  reset();
+}
+
+void Ds1307Emulator::reset() {
+  memset(regs, 0, sizeof(regs));
+  regs[DS1307_REG_SECONDS] = DS1307_BIT_CLOCK_HALT;
+  regs[DS1307_REG_DAY_OF_WEEK] = 0x01;
+  regs[DS1307_REG_DATE] = 0x01;
+  regs[DS1307_REG_MONTH] = 0x01;
+  pointer = 0;
+  syncNanos = simNanos();
+  subsecondNanos = 0;
+  edgeNanos = syncNanos;
+  edgeCount = 0;
+  lastReadSeconds = -1;
+  readNanos = 0;
+  readEdgeNanos = 0;
+}
+
+void Ds1307Emulator::setDateTime(uint8_t years, uint8_t months, uint8_t dayOfMonth, uint8_t dayOfWeek,
+                                 uint8_t hours, uint8_t minutes, uint8_t seconds, bool twelveHour) {
+  syncNanos = simNanos();
+  subsecondNanos = 0;
+  edgeNanos = syncNanos;
+
+  regs[DS1307_REG_SECONDS] = toBcd(seconds);
+  regs[DS1307_REG_MINUTES] = toBcd(minutes);
+  regs[DS1307_REG_HOURS] = twelveHour ? DS1307_BIT_12_HOUR : 0;
+  setHours(hours);
+  regs[DS1307_REG_DAY_OF_WEEK] = toBcd(dayOfWeek);
+  regs[DS1307_REG_DATE] = toBcd(dayOfMonth);
+  regs[DS1307_REG_MONTH] = toBcd(months);
+  regs[DS1307_REG_YEAR] = toBcd(years);
+}
+
+//  ====================================================================================
+
+void Ds1307Emulator::sync(uint64_t nowNanos) {
+  if (nowNanos <= syncNanos) {
+    return;
+  }
+
+  if (running()) {
+    subsecondNanos += (nowNanos - syncNanos) * timeScale;
+    if (subsecondNanos >= DS1307_NANOS_PER_SECOND) {
+      while (subsecondNanos >= DS1307_NANOS_PER_SECOND) {
+        subsecondNanos -= DS1307_NANOS_PER_SECOND;
+        tick();
+      }
+      edgeNanos = nowNanos - (uint64_t)(subsecondNanos / timeScale);
+    }
+  }
+  syncNanos = nowNanos;
+}
+
+void Ds1307Emulator::tick() {
+  edgeCount++;
+
+  uint8_t value = fromBcd(regs[DS1307_REG_SECONDS] & 0x7f) + 1;
+  if (value < 60) {
+    regs[DS1307_REG_SECONDS] = toBcd(value);
+    return;
+  }
+  regs[DS1307_REG_SECONDS] = 0;
+
+  value = fromBcd(regs[DS1307_REG_MINUTES] & 0x7f) + 1;
+  if (value < 60) {
+    regs[DS1307_REG_MINUTES] = toBcd(value);
+    return;
+  }
+  regs[DS1307_REG_MINUTES] = 0;
+
+  value = hours() + 1;
+  if (value < 24) {
+    setHours(value);
+    return;
+  }
+  setHours(0);
+
+  regs[DS1307_REG_DAY_OF_WEEK] = toBcd(fromBcd(regs[DS1307_REG_DAY_OF_WEEK]) % 7 + 1);
+
+  uint8_t months = fromBcd(regs[DS1307_REG_MONTH]);
+  uint8_t years = fromBcd(regs[DS1307_REG_YEAR]);
+  value = fromBcd(regs[DS1307_REG_DATE]) + 1;
+  if (value <= daysInMonth(months, years)) {
+    regs[DS1307_REG_DATE] = toBcd(value);
+    return;
+  }
+  regs[DS1307_REG_DATE] = 0x01;
+
+  if (months < 12) {
+    regs[DS1307_REG_MONTH] = toBcd(months + 1);
+    return;
+  }
+  regs[DS1307_REG_MONTH] = 0x01;
+  regs[DS1307_REG_YEAR] = toBcd((years + 1) % 100);
+}
+
+uint8_t Ds1307Emulator::hours() const {
+  uint8_t value = regs[DS1307_REG_HOURS];
+  if (value & DS1307_BIT_12_HOUR) {
+    return fromBcd(value & 0x1f) % 12 + ((value & DS1307_BIT_PM) ? 12 : 0);
+  }
+  return fromBcd(value & 0x3f);
+}
+
+uint8_t Ds1307Emulator::minutes() const {
+  return fromBcd(regs[DS1307_REG_MINUTES] & 0x7f);
+}
+
+uint8_t Ds1307Emulator::seconds() const {
+  return fromBcd(regs[DS1307_REG_SECONDS] & 0x7f);
+}
+
+void Ds1307Emulator::setHours(uint8_t hours24) {
+  if (regs[DS1307_REG_HOURS] & DS1307_BIT_12_HOUR) {
+    uint8_t hours12 = (hours24 % 12 == 0) ? 12 : hours24 % 12;
+    regs[DS1307_REG_HOURS] = DS1307_BIT_12_HOUR | (hours24 >= 12 ? DS1307_BIT_PM : 0) | toBcd(hours12);
+  } else {
+    regs[DS1307_REG_HOURS] = toBcd(hours24);
+  }
+}
+
+//  ====================================================================================
+
+void Ds1307Emulator::i2cWrite(const uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) {
+  (void)endNanos;
+  sync(startNanos);
+
+  if (length == 0) {
+    return;
+  }
+
+  pointer = data[0] % DS1307_REGISTERS;
+  for (uint8_t r = 1; r < length; r++) {
+    regs[pointer] = data[r];
+    if (pointer == DS1307_REG_SECONDS) {
+      //  Writing the seconds register resets the countdown chain.
+      subsecondNanos = 0;
+      edgeNanos = startNanos;
+    }
+    pointer = (pointer + 1) % DS1307_REGISTERS;
+  }
+}
+
+uint8_t Ds1307Emulator::i2cRead(uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) {
+  (void)endNanos;
+  sync(startNanos);
+  readNanos = startNanos;
+
+  if (skipToEdge && pointer == DS1307_REG_SECONDS && running()) {
+    if (lastReadSeconds == regs[DS1307_REG_SECONDS]) {
+      //  Nothing would change for this poll, fast-forward to the next second edge.
+      tick();
+      subsecondNanos = 0;
+      edgeNanos = startNanos;
+    }
+    lastReadSeconds = regs[DS1307_REG_SECONDS];
+  }
+  readEdgeNanos = edgeNanos;
+
+  for (uint8_t r = 0; r < length; r++) {
+    data[r] = regs[pointer];
+    pointer = (pointer + 1) % DS1307_REGISTERS;
+  }
+  return length;
+}
@@ -0,0 +1,95 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the DS1307 real-time clock at I2C address 0x68.
+//
+// Implements the register protocol used by getDateDs1307() and setDateDs1307(): a register
+// pointer set by the first written byte, auto-incrementing reads and writes over the 64-byte
+// register space, BCD time and date registers, the clock halt (CH) bit in the seconds register
+// and the 12/24 hour bit in the hours register. Writing the seconds register resets the
+// one-second countdown chain like on the real chip.
+//
+// The clock follows the virtual time of the simulator and can be sped up for fast-forward runs:
+//
+//  * setTimeScale(N) lets the clock run N times faster than virtual time.
+//  * setSkipToEdge(true) jumps straight to the next second edge whenever the firmware polls
+//    the seconds register and would otherwise see the same second again, so every poll of
+//    normalMode() sees a new second.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_DS1307_H
+#define CLOCKOS_SIM_DS1307_H
+
+#include <stdint.h>
+
+#include "sim_hal.h"
+
+#define DS1307_REGISTERS  64
+
+//  Register addresses
+#define DS1307_REG_SECONDS      0x00
+#define DS1307_REG_MINUTES      0x01
+#define DS1307_REG_HOURS        0x02
+#define DS1307_REG_DAY_OF_WEEK  0x03
+#define DS1307_REG_DATE         0x04
+#define DS1307_REG_MONTH        0x05
+#define DS1307_REG_YEAR         0x06
+#define DS1307_REG_CONTROL      0x07
+
+//  Control bits
+#define DS1307_BIT_CLOCK_HALT   0x80
+#define DS1307_BIT_12_HOUR      0x40
+#define DS1307_BIT_PM           0x20
+
+class Ds1307Emulator : public SimI2cDevice {
+  public:
+    Ds1307Emulator();
+
+    //  Power-on state: 01/01/00 00:00:00 with the clock halted.
+    void reset();
+
+    //  Sets the time and date and starts the clock, hours are always given as 0-23.
+    void setDateTime(uint8_t years, uint8_t months, uint8_t dayOfMonth, uint8_t dayOfWeek,
+                     uint8_t hours, uint8_t minutes, uint8_t seconds, bool twelveHour = false);
+
+    void setTimeScale(double scale) { sync(simNanos()); timeScale = scale; }
+    void setSkipToEdge(bool enabled) { skipToEdge = enabled; }
+
+    void i2cWrite(const uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) override;
+    uint8_t i2cRead(uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) override;
+
+    uint8_t reg(uint8_t address) const { return regs[address % DS1307_REGISTERS]; }
+    bool running() const { return (regs[DS1307_REG_SECONDS] & DS1307_BIT_CLOCK_HALT) == 0; }
+
+    //  Decoded time, hours as 0-23 in both modes.
+    uint8_t hours() const;
+    uint8_t minutes() const;
+    uint8_t seconds() const;
+
+    //  Virtual time of the latest second edge and the number of edges since reset.
+    uint64_t lastEdgeNanos() const { return edgeNanos; }
+    uint64_t edges() const { return edgeCount; }
+
+    //  Virtual time of the latest read transaction and of the second edge that read saw.
+    uint64_t lastReadNanos() const { return readNanos; }
+    uint64_t lastReadEdgeNanos() const { return readEdgeNanos; }
+
+  private:
+    void sync(uint64_t nowNanos);
+    void tick();
+    void setHours(uint8_t hours24);
+
+    uint8_t regs[DS1307_REGISTERS];
+    uint8_t pointer;
+    double timeScale;
+    bool skipToEdge;
+    uint64_t syncNanos;
+    double subsecondNanos;
+    uint64_t edgeNanos;
+    uint64_t edgeCount;
+    int lastReadSeconds;
+    uint64_t readNanos;
+    uint64_t readEdgeNanos;
+};
+
+#endif
@@ -0,0 +1,118 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Reference renderer of a clock face, see face_reference.h.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "face_reference.h"
+
+//  Style and marker mode bits of the settings bytes, as in src/main.cpp.
+#define REF_STYLE_HANDS       0x10
+#define REF_STYLE_DOT         0x20
+#define REF_STYLE_TRACE       0x40
+#define REF_MARKER_EVERY      0x10
+#define REF_MARKER_QUARTERS   0x20
+#define REF_MARKER_TWELTH     0x40
+#define REF_COLOR_MASK        0x0f
+
+//  Rings covered by a hand, indexed by the hand's own ring.
+static const bool handRings[PIC_RING_COUNT][PIC_RING_COUNT] = {
+  { true,  true,  false },    //  Hours
+  { true,  true,  true  },    //  Minutes
+  { true,  true,  true  }     //  Seconds
+};
+
+uint8_t referenceHoursHand(uint8_t hours, uint8_t minutes) {
+  return (hours % 12) * 5 + minutes / 12;
+}
+
+//  Step between markers, 0 when no markers are shown.
+static uint8_t markerSteps(uint8_t markers) {
+  if ((markers & REF_COLOR_MASK) == 0) {
+    return 0;
+  }
+  if (markers & REF_MARKER_EVERY) {
+    return 5;
+  }
+  if (markers & REF_MARKER_QUARTERS) {
+    return 15;
+  }
+  if (markers & REF_MARKER_TWELTH) {
+    return 60;
+  }
+  return 0;
+}
+
+static void drawHead(uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS], uint8_t settings, uint8_t ring,
+                     uint8_t position, bool markersShown) {
+  uint8_t color = settings & REF_COLOR_MASK;
+  if (color == 0) {
+    return;
+  }
+
+  if (settings & REF_STYLE_TRACE) {
+    if (position > 0 || !markersShown) {
+      leds[ring][position] = color;
+    }
+  } else if (settings & REF_STYLE_DOT) {
+    leds[ring][position] = color;
+  } else if (settings & REF_STYLE_HANDS) {
+    for (uint8_t r = 0; r < PIC_RING_COUNT; r++) {
+      if (handRings[ring][r]) {
+        leds[r][position] = color;
+      }
+    }
+  }
+}
+
+void referenceRenderFace(const uint8_t face[FACE_BYTES], uint8_t hours, uint8_t minutes, uint8_t seconds,
+                         uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]) {
+  const uint8_t settings[PIC_RING_COUNT] = { face[FACE_HOURS], face[FACE_MINUTES], face[FACE_SECONDS] };
+  const uint8_t positions[PIC_RING_COUNT] = { referenceHoursHand(hours, minutes), minutes, seconds };
+
+  memset(leds, 0, PIC_RING_COUNT * PIC_RING_POSITIONS);
+
+  //  Bottom layer: trace bodies
+  for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+    if ((settings[ring] & REF_COLOR_MASK) != 0 && (settings[ring] & REF_STYLE_TRACE)) {
+      for (uint8_t position = 0; position < positions[ring]; position++) {
+        leds[ring][position] = settings[ring] & REF_COLOR_MASK;
+      }
+    }
+  }
+
+  //  Markers
+  uint8_t steps = markerSteps(face[FACE_MARKERS]);
+  if (steps > 0) {
+    for (uint8_t position = 0; position < PIC_RING_POSITIONS; position += steps) {
+      uint8_t firstRing = PIC_RING_SECONDS;
+      if (position == 0) {
+        firstRing = PIC_RING_HOURS;
+      } else if (position % 15 == 0) {
+        firstRing = PIC_RING_MINUTES;
+      }
+      for (uint8_t ring = firstRing; ring < PIC_RING_COUNT; ring++) {
+        leds[ring][position] = face[FACE_MARKERS] & REF_COLOR_MASK;
+      }
+    }
+  }
+
+  //  Top layer: heads in the order composeClockFace() draws them
+  drawHead(leds, settings[PIC_RING_MINUTES], PIC_RING_MINUTES, positions[PIC_RING_MINUTES], steps > 0);
+  drawHead(leds, settings[PIC_RING_HOURS], PIC_RING_HOURS, positions[PIC_RING_HOURS], steps > 0);
+  drawHead(leds, settings[PIC_RING_SECONDS], PIC_RING_SECONDS, positions[PIC_RING_SECONDS], steps > 0);
+}
+
+void referenceRenderSweep(const uint8_t face[FACE_BYTES], uint8_t seconds, bool tail, bool blip,
+                          uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]) {
+  bool markersShown = markerSteps(face[FACE_MARKERS]) > 0;
+  if (tail) {
+    drawHead(leds, face[FACE_SECONDS], PIC_RING_SECONDS, (seconds + PIC_RING_POSITIONS - 1) % PIC_RING_POSITIONS,
+             markersShown);
+  }
+  if (blip) {
+    drawHead(leds, face[FACE_SECONDS], PIC_RING_SECONDS, (seconds + 1) % PIC_RING_POSITIONS, markersShown);
+  }
+}
@@ -0,0 +1,50 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Reference renderer of a clock face: what the three rings should show at a given time, worked
+// out from scratch for every LED instead of incrementally from the previous second.
+//
+// A face is the four settings bytes stored per face in EEPROM: hours markers, hours, minutes
+// and seconds, each a color in bits 0-3 and a style or marker mode in bits 4-6. Bit 7 of the
+// seconds makes the hand sweep between seconds, which does not change the face at the edge.
+// Each LED shows the first of these that covers it:
+//
+//  1. The head of a hand in the draw order of composeClockFace(), later hands covering earlier ones:
+//     minutes, hours, seconds. A dot covers its own ring, an hours hand the hours and minutes
+//     rings, minutes and seconds hands all three rings, and a trace head its own ring. A trace
+//     head at position 0 is the exception and stays under the marker there.
+//  2. An hour marker: all rings at position 0, minutes and seconds rings at 15, 30 and 45, and
+//     the seconds ring elsewhere, every 5, 15 or 60 positions by marker mode.
+//  3. The body of a trace, positions 0 up to its head in its own ring.
+//
+// A hand with a blank color is not shown at all, and neither are markers with a blank color or
+// no marker mode.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_FACE_REFERENCE_H
+#define CLOCKOS_SIM_FACE_REFERENCE_H
+
+#include <stdint.h>
+
+#include "pic_ring.h"
+
+//  Index of each settings byte of a face.
+#define FACE_MARKERS  0
+#define FACE_HOURS    1
+#define FACE_MINUTES  2
+#define FACE_SECONDS  3
+#define FACE_BYTES    4
+
+//  Renders a face at hours 0-23, minutes and seconds into leds, indexed like PicRingEmulator.
+void referenceRenderFace(const uint8_t face[FACE_BYTES], uint8_t hours, uint8_t minutes, uint8_t seconds,
+                         uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]);
+
+//  Adds the sweep of the seconds hand to leds rendered for the same face and time: a tail one
+//  position behind the seconds hand and a blip one ahead, each drawn like the hand's head.
+void referenceRenderSweep(const uint8_t face[FACE_BYTES], uint8_t seconds, bool tail, bool blip,
+                          uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]);
+
+//  Position of the hours hand, which moves on every 12 minutes.
+uint8_t referenceHoursHand(uint8_t hours, uint8_t minutes);
+
+#endif
@@ -0,0 +1,53 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Declarations of the src/main.cpp functions and globals that the simulator tools use.
+//
+// The firmware is a single translation unit without a header, these must be kept in sync with
+// the definitions there.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_FIRMWARE_H
+#define CLOCKOS_SIM_FIRMWARE_H
+
+#include "Arduino.h"
+
+extern byte hours, minutes, seconds, years, months, dayOfMonth, dayOfWeek;
+extern byte clockFace;
+//  Menu the firmware is in, 0 for normal mode.
+extern byte mode;
+extern byte hoursMarkerColor;
+extern byte hoursColor;
+extern byte minutesColor;
+extern byte secondsColor;
+
+void writeFactorySettingsToEeprom();
+void normalMode();
+
+//  Renders a face, its markers, hours, minutes and seconds settings bytes, into a whole frame:
+//  by ring (seconds, minutes, hours), color bit plane and 8 bytes of one bit per position.
+void renderFace(const byte face[4], byte hours, byte minutes, byte seconds, byte frame[3][3][8]);
+//  Turns a frame renderFace() drew at one time into the frame for another, drawing only what
+//  changed.
+void renderFaceChange(const byte face[4], byte fromHours, byte fromMinutes, byte fromSeconds,
+                      byte hours, byte minutes, byte seconds, byte frame[3][3][8]);
+
+//  The ring command queue, see src/main.cpp. Tools that run one loop() per tick wait for the
+//  whole face to be sent, like loop() does by spinning until the next second.
+bool ringFrameSent();
+void ringFrameFlushAndWait();
+
+//  Steps of the seconds sweep drawn in this second, and the overlay the rings show: bit 0 the
+//  tail behind the seconds hand, bit 1 the blip ahead of it.
+extern byte sweepStep;
+extern byte sweepShown;
+
+//  Ring link error counters: echo timeouts and echoes that were not expected.
+extern unsigned int ringLinkTimeouts;
+extern unsigned int ringLinkErrors;
+
+//  Queue the ring command byte written last came from, 1 for the low priority queue the
+//  background scrubber uses.
+extern byte ringQueueSending;
+
+#endif
@@ -0,0 +1,80 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Host-native Arduino shim for running the ClockOS firmware on Linux.
+//
+// Only the parts of the Arduino core that src/main.cpp actually uses are provided. Time is
+// virtual: millis()/micros() report the simulated clock and delay() advances it, so a full
+// simulated day can run in a fraction of the real time. See sim_hal.h for the simulator side.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_ARDUINO_H
+#define CLOCKOS_SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "binary.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH  0x1
+#define LOW   0x0
+
+#define INPUT         0x0
+#define OUTPUT        0x1
+#define INPUT_PULLUP  0x2
+
+#define bit(b)                (1UL << (b))
+#define bitRead(value, bit)   (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)    ((value) |= (1UL << (bit)))
+#define bitClear(value, bit)  ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue)  ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#define _BV(bit)              (1 << (bit))
+
+//  Program memory is plain memory on the host.
+#define PROGMEM
+#define PSTR(s)               (s)
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t *)(addr))
+
+char *strncpy_P(char *dest, const char *src, size_t n);
+void *memcpy_P(void *dest, const void *src, size_t n);
+
+//  Sketch entry points, implemented by src/main.cpp.
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+class HardwareSerial {
+  public:
+    void begin(unsigned long baud);
+    void end();
+    int available();
+    int read();
+    int peek();
+    int availableForWrite();
+    void flush();
+    size_t write(uint8_t b);
+
+    unsigned long baudRate() const { return baud; }
+
+  private:
+    unsigned long baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif
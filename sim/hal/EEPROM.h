@@ -0,0 +1,24 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Host-native EEPROM shim, 512 bytes like the ATmega168. A fresh EEPROM reads as erased (0xFF).
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_EEPROM_H
+#define CLOCKOS_SIM_EEPROM_H
+
+#include <stdint.h>
+
+#define SIM_EEPROM_SIZE 512
+
+class EEPROMClass {
+  public:
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() { return SIM_EEPROM_SIZE; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
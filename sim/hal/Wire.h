@@ -0,0 +1,52 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Host-native Wire (I2C master) shim.
+//
+// Transactions are routed to the devices attached with simAttachI2c(). Each transaction blocks
+// for its bus time like the AVR TWI driver does, i.e. the virtual clock is advanced by the
+// time it takes to clock out start, address, data and stop at the configured bus speed.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_WIRE_H
+#define CLOCKOS_SIM_WIRE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+  public:
+    void begin();
+    void end();
+    void setClock(uint32_t clock);
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(uint8_t sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t quantity);
+    size_t write(int data) { return write((uint8_t)data); }
+    int available();
+    int read();
+    int peek();
+
+  private:
+    uint32_t clock = 100000;
+    uint8_t txAddress = 0;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength = 0;
+    bool transmitting = false;
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxIndex = 0;
+    uint8_t rxLength = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,447 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Host-native implementation of the Arduino shim and the simulator HAL.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <time.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "Wire.h"
+#include "sim_hal.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+struct SimUartByte {
+  uint8_t data;
+  uint64_t startNanos;
+  uint64_t endNanos;
+};
+
+static uint64_t nowNanos = 0;
+
+static double pacingSpeed = 0;
+static uint64_t pacingWallStart = 0;
+static uint64_t pacingVirtualStart = 0;
+
+static void (*delayHook)(unsigned long ms) = nullptr;
+static void (*uartWriteHook)(uint8_t data) = nullptr;
+
+static uint8_t pinLevels[SIM_PIN_COUNT];
+static uint8_t eeprom[SIM_EEPROM_SIZE];
+
+static SimUartPeer *uartPeer = nullptr;
+static unsigned long uartBaud = 0;
+static uint64_t uartByteNanos = 0;
+static uint64_t uartLineFreeNanos = 0;
+static uint64_t uartBytesWritten = 0;
+static std::deque<SimUartByte> uartTx;
+static std::deque<SimUartByte> uartRxPending;
+static std::deque<uint8_t> uartRx;
+
+static std::map<uint8_t, SimI2cDevice *> i2cDevices;
+static uint64_t i2cBytesTransferred = 0;
+
+//  ====================================================================================
+
+static uint64_t wallNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//  Deliver everything that has happened on the UART up to the current virtual time.
+static void uartService() {
+  while (!uartTx.empty() && uartTx.front().endNanos <= nowNanos) {
+    SimUartByte b = uartTx.front();
+    uartTx.pop_front();
+    if (uartPeer != nullptr) {
+      uartPeer->uartReceive(b.data, b.startNanos, b.endNanos);
+    }
+  }
+
+  while (!uartRxPending.empty() && uartRxPending.front().endNanos <= nowNanos) {
+    // Bytes arriving with a full RX buffer are lost, like on the AVR.
+    if (uartRx.size() < SIM_SERIAL_RX_BUFFER_SIZE - 1) {
+      uartRx.push_back(uartRxPending.front().data);
+    }
+    uartRxPending.pop_front();
+  }
+}
+
+//  Number of bytes waiting in the TX buffer, i.e. not yet moved to the shift register.
+static size_t uartTxQueued() {
+  size_t queued = 0;
+  for (size_t r = 0; r < uartTx.size(); r++) {
+    if (uartTx[r].startNanos > nowNanos) {
+      queued++;
+    }
+  }
+  return queued;
+}
+
+//  ====================================================================================
+
+void simReset() {
+  nowNanos = 0;
+  pacingWallStart = wallNanos();
+  pacingVirtualStart = 0;
+
+  memset(pinLevels, HIGH, sizeof(pinLevels));
+  memset(eeprom, 0xff, sizeof(eeprom));
+
+  uartPeer = nullptr;
+  uartBaud = 0;
+  uartByteNanos = 0;
+  uartLineFreeNanos = 0;
+  uartBytesWritten = 0;
+  uartTx.clear();
+  uartRxPending.clear();
+  uartRx.clear();
+
+  i2cDevices.clear();
+  i2cBytesTransferred = 0;
+
+  delayHook = nullptr;
+  uartWriteHook = nullptr;
+}
+
+uint64_t simNanos() {
+  return nowNanos;
+}
+
+void simAdvanceTo(uint64_t nanos) {
+  if (nanos <= nowNanos) {
+    return;
+  }
+  nowNanos = nanos;
+  uartService();
+
+  if (pacingSpeed > 0) {
+    uint64_t target = pacingWallStart + (uint64_t)((nowNanos - pacingVirtualStart) / pacingSpeed);
+    uint64_t wall = wallNanos();
+    if (target > wall) {
+      struct timespec ts;
+      ts.tv_sec = (target - wall) / 1000000000ULL;
+      ts.tv_nsec = (target - wall) % 1000000000ULL;
+      nanosleep(&ts, nullptr);
+    }
+  }
+}
+
+void simAdvance(uint64_t nanos) {
+  simAdvanceTo(nowNanos + nanos);
+}
+
+void simSetPacing(double speed) {
+  pacingSpeed = speed;
+  pacingWallStart = wallNanos();
+  pacingVirtualStart = nowNanos;
+}
+
+void simSetDelayHook(void (*hook)(unsigned long ms)) {
+  delayHook = hook;
+}
+
+void simSetUartWriteHook(void (*hook)(uint8_t data)) {
+  uartWriteHook = hook;
+}
+
+void simSetPin(uint8_t pin, uint8_t level) {
+  if (pin < SIM_PIN_COUNT) {
+    pinLevels[pin] = level;
+  }
+}
+
+uint8_t simGetPin(uint8_t pin) {
+  return pin < SIM_PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+void simAttachUart(SimUartPeer *peer) {
+  uartPeer = peer;
+}
+
+void simUartInject(uint8_t data, uint64_t atNanos) {
+  SimUartByte b = {data, atNanos, atNanos};
+  uartRxPending.push_back(b);
+}
+
+uint64_t simUartIdleNanos() {
+  return uartLineFreeNanos > nowNanos ? uartLineFreeNanos : nowNanos;
+}
+
+//  End of the last byte written so far, even if it is still waiting in the TX buffer.
+uint64_t simUartLastByteEndNanos() {
+  return uartLineFreeNanos;
+}
+
+uint64_t simUartBytesWritten() {
+  return uartBytesWritten;
+}
+
+unsigned long simUartBaud() {
+  return uartBaud;
+}
+
+void simAttachI2c(uint8_t address, SimI2cDevice *device) {
+  i2cDevices[address] = device;
+}
+
+uint64_t simI2cBytesTransferred() {
+  return i2cBytesTransferred;
+}
+
+uint8_t *simEeprom() {
+  return eeprom;
+}
+
+//  ====================================================================================
+
+char *strncpy_P(char *dest, const char *src, size_t n) {
+  return strncpy(dest, src, n);
+}
+
+void *memcpy_P(void *dest, const void *src, size_t n) {
+  return memcpy(dest, src, n);
+}
+
+unsigned long millis() {
+  return (unsigned long)(nowNanos / 1000000ULL);
+}
+
+unsigned long micros() {
+  return (unsigned long)(nowNanos / 1000ULL);
+}
+
+//  Calls yield() while waiting like the AVR core does, once every millisecond of virtual time.
+void delay(unsigned long ms) {
+  if (delayHook != nullptr) {
+    delayHook(ms);
+  }
+  uint64_t end = nowNanos + (uint64_t)ms * 1000000ULL;
+  yield();
+  while (nowNanos < end) {
+    simAdvanceTo(std::min<uint64_t>(end, nowNanos + 1000000ULL));
+    yield();
+  }
+}
+
+//  The sketch can replace this, as on the AVR.
+__attribute__((weak)) void yield() {
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvance((uint64_t)us * 1000ULL);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+int digitalRead(uint8_t pin) {
+  return simGetPin(pin);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  simSetPin(pin, value);
+}
+
+//  ====================================================================================
+
+void HardwareSerial::begin(unsigned long rate) {
+  baud = rate;
+  uartBaud = rate;
+  //  8N1, start + 8 data + stop bits per byte
+  uartByteNanos = 10ULL * 1000000000ULL / rate;
+}
+
+void HardwareSerial::end() {
+  flush();
+  baud = 0;
+  uartBaud = 0;
+}
+
+int HardwareSerial::available() {
+  uartService();
+  return (int)uartRx.size();
+}
+
+int HardwareSerial::read() {
+  uartService();
+  if (uartRx.empty()) {
+    return -1;
+  }
+  int data = uartRx.front();
+  uartRx.pop_front();
+  return data;
+}
+
+int HardwareSerial::peek() {
+  uartService();
+  return uartRx.empty() ? -1 : uartRx.front();
+}
+
+int HardwareSerial::availableForWrite() {
+  uartService();
+  return (int)(SIM_SERIAL_TX_BUFFER_SIZE - 1 - uartTxQueued());
+}
+
+void HardwareSerial::flush() {
+  simAdvanceTo(uartLineFreeNanos);
+}
+
+size_t HardwareSerial::write(uint8_t b) {
+  if (baud == 0) {
+    return 0;
+  }
+
+  uartService();
+
+  //  Block while the TX buffer is full, the same as HardwareSerial does.
+  while (uartTxQueued() >= SIM_SERIAL_TX_BUFFER_SIZE - 1) {
+    for (size_t r = 0; r < uartTx.size(); r++) {
+      if (uartTx[r].startNanos > nowNanos) {
+        simAdvanceTo(uartTx[r].startNanos);
+        break;
+      }
+    }
+  }
+
+  SimUartByte txByte;
+  txByte.data = b;
+  txByte.startNanos = uartLineFreeNanos > nowNanos ? uartLineFreeNanos : nowNanos;
+  txByte.endNanos = txByte.startNanos + uartByteNanos;
+  uartLineFreeNanos = txByte.endNanos;
+  uartTx.push_back(txByte);
+  uartBytesWritten++;
+  if (uartWriteHook != nullptr) {
+    uartWriteHook(b);
+  }
+  return 1;
+}
+
+//  ====================================================================================
+
+//  Bus time of one transaction: start, address and data bytes with ACK bit, stop.
+static uint64_t i2cTransactionNanos(uint32_t clock, uint8_t length) {
+  uint64_t bits = 1 + 9 * (1 + (uint64_t)length) + 1;
+  return bits * 1000000000ULL / clock;
+}
+
+void TwoWire::begin() {
+  txLength = 0;
+  rxIndex = 0;
+  rxLength = 0;
+}
+
+void TwoWire::end() {
+}
+
+void TwoWire::setClock(uint32_t value) {
+  clock = value;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  txAddress = address;
+  txLength = 0;
+  transmitting = true;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop) {
+  (void)sendStop;
+  transmitting = false;
+
+  uint64_t start = simNanos();
+  std::map<uint8_t, SimI2cDevice *>::iterator device = i2cDevices.find(txAddress);
+  if (device == i2cDevices.end()) {
+    //  Address NACK, only the address byte was clocked out.
+    simAdvance(i2cTransactionNanos(clock, 0));
+    i2cBytesTransferred++;
+    return 2;
+  }
+
+  uint64_t end = start + i2cTransactionNanos(clock, txLength);
+  device->second->i2cWrite(txBuffer, txLength, start, end);
+  i2cBytesTransferred += 1 + txLength;
+  simAdvanceTo(end);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+  (void)sendStop;
+  if (quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+
+  rxIndex = 0;
+  rxLength = 0;
+
+  uint64_t start = simNanos();
+  std::map<uint8_t, SimI2cDevice *>::iterator device = i2cDevices.find(address);
+  if (device == i2cDevices.end()) {
+    simAdvance(i2cTransactionNanos(clock, 0));
+    i2cBytesTransferred++;
+    return 0;
+  }
+
+  uint64_t end = start + i2cTransactionNanos(clock, quantity);
+  rxLength = device->second->i2cRead(rxBuffer, quantity, start, end);
+  i2cBytesTransferred += 1 + quantity;
+  simAdvanceTo(end);
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!transmitting || txLength >= BUFFER_LENGTH) {
+    return 0;
+  }
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity) {
+  size_t written = 0;
+  for (size_t r = 0; r < quantity; r++) {
+    written += write(data[r]);
+  }
+  return written;
+}
+
+int TwoWire::available() {
+  return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+  return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+  return rxIndex < rxLength ? rxBuffer[rxIndex] : -1;
+}
+
+//  ====================================================================================
+
+uint8_t EEPROMClass::read(int address) {
+  return (address >= 0 && address < SIM_EEPROM_SIZE) ? eeprom[address] : 0xff;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address >= 0 && address < SIM_EEPROM_SIZE) {
+    eeprom[address] = value;
+  }
+  //  An EEPROM write blocks for its programming time.
+  simAdvance(3300000ULL);
+}
+
+void EEPROMClass::update(int address, uint8_t value) {
+  if (read(address) != value) {
+    write(address, value);
+  }
+}
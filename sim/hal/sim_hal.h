@@ -0,0 +1,86 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Simulator side of the host-native hardware abstraction layer.
+//
+// The firmware sees the Arduino API (Arduino.h, Wire.h, EEPROM.h). The simulator uses this
+// header to drive the virtual clock, the button pins and to attach emulated peripherals:
+//
+//  * One UART peer that receives every byte written with Serial.write(). Bytes are delivered
+//    with the time their start and stop bits are on the wire at the baud rate given to
+//    Serial.begin(), after passing through a TX buffer of the same size as on the AVR.
+//  * Any number of I2C devices, addressed by their 7-bit address.
+//
+// All timestamps are nanoseconds of virtual time since simReset().
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_HAL_H
+#define CLOCKOS_SIM_HAL_H
+
+#include <stdint.h>
+
+//  Size of the HardwareSerial TX and RX ring buffers on the ATmega168.
+#define SIM_SERIAL_TX_BUFFER_SIZE 64
+#define SIM_SERIAL_RX_BUFFER_SIZE 64
+
+//  Number of digital pins on the ATmega168.
+#define SIM_PIN_COUNT 20
+
+class SimUartPeer {
+  public:
+    virtual ~SimUartPeer() {}
+
+    //  Called once the stop bit of a byte written by the firmware has been clocked out.
+    virtual void uartReceive(uint8_t data, uint64_t startNanos, uint64_t endNanos) = 0;
+};
+
+class SimI2cDevice {
+  public:
+    virtual ~SimI2cDevice() {}
+
+    //  Master write transaction, data excludes the address byte.
+    virtual void i2cWrite(const uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) = 0;
+
+    //  Master read transaction, returns the number of bytes supplied.
+    virtual uint8_t i2cRead(uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) = 0;
+};
+
+//  Resets virtual time, pins, EEPROM (to erased), serial state and detaches all peers.
+void simReset();
+
+//  Virtual clock.
+uint64_t simNanos();
+void simAdvance(uint64_t nanos);
+void simAdvanceTo(uint64_t nanos);
+
+//  Pace virtual time against the wall clock, 1.0 is real time and 0 runs unpaced.
+void simSetPacing(double speed);
+
+//  Called with the length of every delay() before it starts waiting, so a tool can look at the
+//  board where the firmware pauses, nullptr for none.
+void simSetDelayHook(void (*hook)(unsigned long ms));
+
+//  Called with every byte the firmware writes to the UART, as it goes into the TX buffer, so a
+//  tool can tell what the firmware was sending it for, nullptr for none.
+void simSetUartWriteHook(void (*hook)(uint8_t data));
+
+//  Input level seen by digitalRead(), buttons idle HIGH and read LOW when pressed.
+void simSetPin(uint8_t pin, uint8_t level);
+uint8_t simGetPin(uint8_t pin);
+
+//  UART link to the ring controller.
+void simAttachUart(SimUartPeer *peer);
+void simUartInject(uint8_t data, uint64_t atNanos);
+uint64_t simUartIdleNanos();
+uint64_t simUartLastByteEndNanos();
+uint64_t simUartBytesWritten();
+unsigned long simUartBaud();
+
+//  I2C bus.
+void simAttachI2c(uint8_t address, SimI2cDevice *device);
+uint64_t simI2cBytesTransferred();
+
+//  Raw EEPROM contents.
+uint8_t *simEeprom();
+
+#endif
@@ -0,0 +1,119 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the HT16K33 display driver, see ht16k33.h.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "ht16k33.h"
+
+struct Ht16k33Glyph {
+  uint8_t segments;
+  char character;
+};
+
+//  Same patterns as translateCharTo7SegDigit() in src/main.cpp, first match wins for
+//  characters sharing a pattern (1/i/I, 5/s/S, 0/O).
+static const Ht16k33Glyph glyphs[] = {
+  {0x00, ' '}, {0x40, '-'}, {0x08, '_'}, {0x48, '='},
+  {0x3F, '0'}, {0x06, '1'}, {0x5B, '2'}, {0x4F, '3'}, {0x66, '4'},
+  {0x6D, '5'}, {0x7D, '6'}, {0x07, '7'}, {0x7F, '8'}, {0x6F, '9'},
+  {0x77, 'A'}, {0x7C, 'b'}, {0x39, 'C'}, {0x5E, 'd'}, {0x79, 'E'},
+  {0x71, 'F'}, {0x3D, 'G'}, {0x74, 'h'}, {0x76, 'H'}, {0x1E, 'J'},
+  {0x38, 'L'}, {0x54, 'n'}, {0x5C, 'o'}, {0x73, 'P'}, {0x67, 'Q'},
+  {0x50, 'r'}, {0x78, 't'}, {0x3E, 'U'}, {0x53, '?'}
+};
+
+char ht16k33SegmentsToChar(uint8_t segments) {
+  for (size_t r = 0; r < sizeof(glyphs) / sizeof(glyphs[0]); r++) {
+    if (glyphs[r].segments == segments) {
+      return glyphs[r].character;
+    }
+  }
+  return '#';
+}
+
+//  ====================================================================================
+
+Ht16k33Emulator::Ht16k33Emulator() {
+  recording = true;
+  reset();
+}
+
+void Ht16k33Emulator::reset() {
+  memset(ram, 0, sizeof(ram));
+  pointer = 0;
+  oscillator = false;
+  display = false;
+  blink = 0;
+  dimming = 15;
+  memset(&totals, 0, sizeof(totals));
+  recorded.clear();
+}
+
+void Ht16k33Emulator::i2cWrite(const uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) {
+  if (length == 0) {
+    record(HT16K33_TX_OTHER, length, startNanos, endNanos);
+    return;
+  }
+
+  uint8_t command = data[0];
+  uint8_t kind = HT16K33_TX_OTHER;
+
+  if ((command & 0xf0) == 0x00) {
+    //  Display data address pointer, following bytes auto-increment and wrap.
+    pointer = command & 0x0f;
+    for (uint8_t r = 1; r < length; r++) {
+      ram[pointer] = data[r];
+      pointer = (pointer + 1) % HT16K33_RAM_SIZE;
+    }
+    kind = HT16K33_TX_DISPLAY_DATA;
+  } else if ((command & 0xf0) == 0x20) {
+    oscillator = command & 0x01;
+    kind = HT16K33_TX_SYSTEM_SETUP;
+  } else if ((command & 0xf0) == 0x80) {
+    display = command & 0x01;
+    blink = (command >> 1) & 0x03;
+    kind = HT16K33_TX_DISPLAY_SETUP;
+  } else if ((command & 0xf0) == 0xe0) {
+    dimming = command & 0x0f;
+    kind = HT16K33_TX_DIMMING;
+  }
+
+  record(kind, length, startNanos, endNanos);
+}
+
+uint8_t Ht16k33Emulator::i2cRead(uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) {
+  //  Only key scan data can be read, no keys are connected on the display board.
+  memset(data, 0, length);
+  record(HT16K33_TX_READ, length, startNanos, endNanos);
+  return length;
+}
+
+void Ht16k33Emulator::record(uint8_t kind, uint8_t length, uint64_t startNanos, uint64_t endNanos) {
+  totals.transactions++;
+  totals.bytes += 1 + length;
+  totals.busNanos += endNanos - startNanos;
+
+  if (recording) {
+    Ht16k33Transaction transaction = {kind, (uint8_t)(1 + length), startNanos, endNanos};
+    recorded.push_back(transaction);
+  }
+}
+
+char Ht16k33Emulator::character(uint8_t index) const {
+  if (index >= HT16K33_DISPLAY_CHARS) {
+    return ' ';
+  }
+  return ht16k33SegmentsToChar(ram[(HT16K33_DISPLAY_CHARS - 1 - index) * 2]);
+}
+
+void Ht16k33Emulator::print(FILE *out) const {
+  fprintf(out, "[");
+  for (uint8_t r = 0; r < HT16K33_DISPLAY_CHARS; r++) {
+    fputc(character(r), out);
+  }
+  fprintf(out, "] colons %X mode %X %s brightness %u blink %u\n",
+          colons(), modeLeds(), (oscillator && display) ? "on" : "off", dimming, blink);
+}
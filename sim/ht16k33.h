@@ -0,0 +1,94 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the HT16K33 driving the 7-segment display board at I2C address 0x70.
+//
+// Keeps the 16-byte display RAM and the system, display and dimming setup, and decodes the RAM
+// back into what the board shows using the layout written by ledSegmentsDisplayChars():
+//
+//  RAM 0, 2, 4, 6, 8, 10   Segments of character 5 down to character 0
+//  RAM 13 bits 0-3         Colon LEDs
+//  RAM 13 bits 4-7         Mode LEDs
+//
+// Every transaction is recorded with its size and bus time so the I2C cost of a redraw can be
+// measured.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_HT16K33_H
+#define CLOCKOS_SIM_HT16K33_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "sim_hal.h"
+
+#define HT16K33_RAM_SIZE      16
+#define HT16K33_DISPLAY_CHARS 6
+
+//  Kind of recorded transaction, from the command in the first byte.
+#define HT16K33_TX_DISPLAY_DATA   0
+#define HT16K33_TX_SYSTEM_SETUP   1
+#define HT16K33_TX_DISPLAY_SETUP  2
+#define HT16K33_TX_DIMMING        3
+#define HT16K33_TX_READ           4
+#define HT16K33_TX_OTHER          5
+
+struct Ht16k33Transaction {
+  uint8_t kind;
+  uint8_t bytes;        //  Including the address byte
+  uint64_t startNanos;
+  uint64_t endNanos;
+};
+
+struct Ht16k33Stats {
+  uint64_t transactions;
+  uint64_t bytes;
+  uint64_t busNanos;
+};
+
+class Ht16k33Emulator : public SimI2cDevice {
+  public:
+    Ht16k33Emulator();
+
+    void reset();
+    void setRecording(bool enabled) { recording = enabled; }
+
+    void i2cWrite(const uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) override;
+    uint8_t i2cRead(uint8_t *data, uint8_t length, uint64_t startNanos, uint64_t endNanos) override;
+
+    const uint8_t *displayRam() const { return ram; }
+    bool oscillatorOn() const { return oscillator; }
+    bool displayOn() const { return display; }
+    uint8_t blinkRate() const { return blink; }
+    uint8_t brightness() const { return dimming; }
+
+    //  Decoded display contents.
+    char character(uint8_t index) const;
+    uint8_t colons() const { return ram[13] & 0x0f; }
+    uint8_t modeLeds() const { return ram[13] >> 4; }
+
+    const Ht16k33Stats &stats() const { return totals; }
+    const std::vector<Ht16k33Transaction> &transactions() const { return recorded; }
+    void clearTransactions() { recorded.clear(); }
+
+    void print(FILE *out) const;
+
+  private:
+    void record(uint8_t kind, uint8_t length, uint64_t startNanos, uint64_t endNanos);
+
+    uint8_t ram[HT16K33_RAM_SIZE];
+    uint8_t pointer;
+    bool oscillator;
+    bool display;
+    uint8_t blink;
+    uint8_t dimming;
+    bool recording;
+    Ht16k33Stats totals;
+    std::vector<Ht16k33Transaction> recorded;
+};
+
+//  Character shown by a segment pattern, as written by translateCharTo7SegDigit().
+char ht16k33SegmentsToChar(uint8_t segments);
+
+#endif
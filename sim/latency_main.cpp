@@ -0,0 +1,305 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Tick-to-display latency benchmark: runs every factory clock face in real virtual time and
+// reports, for every second drawn in normal mode, how long after the DS1307 second edge the
+// last byte of that second's update left the board.
+//
+// Usage: program [--seconds <n>] [--face <n>] [--histogram] [--baseline <file>]
+//                [--write-baseline <file>] [--tolerance <percent>]
+//   --seconds         Simulated seconds per face (default 3600).
+//   --face            Only run this face.
+//   --histogram       Print the latency distribution of each face in 10 ms buckets.
+//   --baseline        Compare the median, 99th percentile and worst total and the worst detect
+//                     latency against a baseline, exit with 1 if any regressed by more than the
+//                     tolerance. The baseline is for all faces at the default seconds.
+//   --write-baseline  Write the measured figures as a new baseline.
+//   --tolerance       Allowed regression in percent (default 2).
+//
+// A tick's latency is split in two parts:
+//
+//  * detect   From the second edge to the RTC read that sees the new second. While no key is
+//             down loop() polls the RTC again right away, so this is at most one pass of loop()
+//             and one RTC read.
+//  * update   From that read to the end of the last ring command byte on the UART or the last
+//             HT16K33 display data transaction, whichever is later.
+//
+// Unlike the bus-traffic benchmark the RTC runs at normal speed, so the phase of the second
+// edge against the loop drifts the same way it does on the board.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "board.h"
+#include "firmware.h"
+
+#define LATENCY_DEFAULT_SECONDS   3600
+#define LATENCY_MAX_SECONDS       86400
+#define LATENCY_BUCKET_MS         10
+#define LATENCY_BUCKETS           50
+
+//  Measured parts of a tick, in the order they are printed.
+#define LATENCY_TOTAL   0
+#define LATENCY_DETECT  1
+#define LATENCY_UPDATE  2
+#define LATENCY_PARTS   3
+
+//  Figures kept in the baseline, in the order they are stored.
+#define LATENCY_TOTAL_P50   0
+#define LATENCY_TOTAL_P99   1
+#define LATENCY_TOTAL_MAX   2
+#define LATENCY_DETECT_MAX  3
+#define LATENCY_METRICS     4
+
+struct LatencyResult {
+  uint32_t ticks;
+  float micros[LATENCY_PARTS][LATENCY_MAX_SECONDS];
+};
+
+static const char *partNames[LATENCY_PARTS] = { "total", "detect", "update" };
+static const char *metricNames[LATENCY_METRICS] = { "total p50 ms", "total p99 ms", "total max ms", "detect max ms" };
+
+static SimBoard board;
+static uint32_t runSeconds = LATENCY_DEFAULT_SECONDS;
+
+//  Nearest-rank percentile of sorted values.
+static double percentile(const std::vector<float> &sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = (size_t)ceil(fraction * sorted.size());
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void runFace(void *arg, void *output) {
+  int face = *(int *)arg;
+  LatencyResult &result = *(LatencyResult *)output;
+
+  board.powerOn();
+  board.loadFactorySettings(face);
+  board.pic.setRecording(false);
+  board.display.setRecording(true);
+
+  setup();
+  board.rtc.setDateTime(20, 1, 1, 4, 10, 8, 0);
+
+  //  The first pass draws the whole face from scratch and is not a tick.
+  loop();
+  ringFrameFlushAndWait();
+
+  result.ticks = 0;
+  uint64_t endNanos = simNanos() + runSeconds * 1000000000ULL;
+  byte lastSeconds = seconds;
+
+  while (simNanos() < endNanos && result.ticks < LATENCY_MAX_SECONDS) {
+    board.display.clearTransactions();
+    uint64_t ringDone = simUartLastByteEndNanos();
+
+    loop();
+    if (seconds == lastSeconds) {
+      continue;
+    }
+    lastSeconds = seconds;
+
+    uint64_t edge = board.rtc.lastReadEdgeNanos();
+    uint64_t read = board.rtc.lastReadNanos();
+
+    //  Ring commands that did not fit in the queue go out over the next passes.
+    while (!ringFrameSent()) {
+      loop();
+    }
+    uint64_t done = read;
+    if (simUartLastByteEndNanos() != ringDone) {
+      done = std::max(done, simUartLastByteEndNanos());
+    }
+    const std::vector<Ht16k33Transaction> &transactions = board.display.transactions();
+    for (size_t r = 0; r < transactions.size(); r++) {
+      if (transactions[r].kind == HT16K33_TX_DISPLAY_DATA) {
+        done = std::max(done, transactions[r].endNanos);
+      }
+    }
+
+    result.micros[LATENCY_TOTAL][result.ticks] = (done - edge) / 1e3;
+    result.micros[LATENCY_DETECT][result.ticks] = (read - edge) / 1e3;
+    result.micros[LATENCY_UPDATE][result.ticks] = (done - read) / 1e3;
+    result.ticks++;
+  }
+}
+
+static bool readBaseline(const char *path, double baseline[SIM_FACTORY_FACES][LATENCY_METRICS]) {
+  FILE *in = fopen(path, "r");
+  if (in == nullptr) {
+    fprintf(stderr, "Cannot read baseline %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  int loaded = 0;
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    int face;
+    double m[LATENCY_METRICS];
+    if (line[0] == '#') {
+      continue;
+    }
+    if (sscanf(line, "%d %lf %lf %lf %lf", &face, &m[0], &m[1], &m[2], &m[3]) == 1 + LATENCY_METRICS &&
+        face >= 0 && face < SIM_FACTORY_FACES) {
+      memcpy(baseline[face], m, sizeof(m));
+      loaded++;
+    }
+  }
+  fclose(in);
+
+  if (loaded != SIM_FACTORY_FACES) {
+    fprintf(stderr, "Baseline %s has %d of %d faces\n", path, loaded, SIM_FACTORY_FACES);
+    return false;
+  }
+  return true;
+}
+
+static bool writeBaseline(const char *path, const double metrics[SIM_FACTORY_FACES][LATENCY_METRICS]) {
+  FILE *out = fopen(path, "w");
+  if (out == nullptr) {
+    fprintf(stderr, "Cannot write baseline %s\n", path);
+    return false;
+  }
+
+  fprintf(out, "# Tick-to-display latency baseline, %u simulated seconds per factory face.\n", runSeconds);
+  fprintf(out, "# face total_p50_ms total_p99_ms total_max_ms detect_max_ms\n");
+  for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+    const double *m = metrics[face];
+    fprintf(out, "%d %.3f %.3f %.3f %.3f\n", face, m[0], m[1], m[2], m[3]);
+  }
+  fclose(out);
+  return true;
+}
+
+static void printHistogram(const std::vector<float> &values) {
+  uint32_t buckets[LATENCY_BUCKETS + 1] = { 0 };
+  uint32_t most = 1;
+  for (size_t r = 0; r < values.size(); r++) {
+    size_t bucket = std::min((size_t)(values[r] / 1000 / LATENCY_BUCKET_MS), (size_t)LATENCY_BUCKETS);
+    most = std::max(most, ++buckets[bucket]);
+  }
+
+  for (int bucket = 0; bucket <= LATENCY_BUCKETS; bucket++) {
+    if (buckets[bucket] == 0) {
+      continue;
+    }
+    if (bucket == LATENCY_BUCKETS) {
+      printf("      >=%4d ms %7u ", bucket * LATENCY_BUCKET_MS, buckets[bucket]);
+    } else {
+      printf("  %4d-%4d ms %7u ", bucket * LATENCY_BUCKET_MS, (bucket + 1) * LATENCY_BUCKET_MS, buckets[bucket]);
+    }
+    for (uint32_t bar = 0; bar < (buckets[bucket] * 50 + most - 1) / most; bar++) {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+}
+
+int main(int argc, char **argv) {
+  int onlyFace = -1;
+  bool histogram = false;
+  const char *baselinePath = nullptr;
+  const char *writePath = nullptr;
+  double tolerance = 2.0;
+
+  for (int r = 1; r < argc; r++) {
+    if (strcmp(argv[r], "--seconds") == 0 && r + 1 < argc) {
+      runSeconds = std::min(atoi(argv[++r]), LATENCY_MAX_SECONDS);
+    } else if (strcmp(argv[r], "--face") == 0 && r + 1 < argc) {
+      onlyFace = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--histogram") == 0) {
+      histogram = true;
+    } else if (strcmp(argv[r], "--baseline") == 0 && r + 1 < argc) {
+      baselinePath = argv[++r];
+    } else if (strcmp(argv[r], "--write-baseline") == 0 && r + 1 < argc) {
+      writePath = argv[++r];
+    } else if (strcmp(argv[r], "--tolerance") == 0 && r + 1 < argc) {
+      tolerance = atof(argv[++r]);
+    } else {
+      fprintf(stderr, "Usage: %s [--seconds <n>] [--face <n>] [--histogram] [--baseline <file>]\n"
+                      "          [--write-baseline <file>] [--tolerance <percent>]\n", argv[0]);
+      return 1;
+    }
+  }
+  if ((baselinePath != nullptr || writePath != nullptr) && onlyFace >= 0) {
+    fprintf(stderr, "The baseline is for all faces, --face cannot be used with it\n");
+    return 1;
+  }
+
+  LatencyResult *result = (LatencyResult *)malloc(sizeof(LatencyResult));
+  double metrics[SIM_FACTORY_FACES][LATENCY_METRICS];
+
+  printf("Face  Part     Ticks   min ms   p50 ms   p90 ms   p99 ms   max ms  mean ms   std ms\n");
+  for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+    if (onlyFace >= 0 && face != onlyFace) {
+      continue;
+    }
+    if (!simRunIsolated(runFace, &face, result, sizeof(LatencyResult))) {
+      fprintf(stderr, "Simulation of face %d failed\n", face);
+      return 1;
+    }
+
+    std::vector<float> sorted[LATENCY_PARTS];
+    for (int part = 0; part < LATENCY_PARTS; part++) {
+      sorted[part].assign(result->micros[part], result->micros[part] + result->ticks);
+      std::sort(sorted[part].begin(), sorted[part].end());
+
+      double sum = 0, squares = 0;
+      for (size_t r = 0; r < sorted[part].size(); r++) {
+        sum += sorted[part][r];
+        squares += (double)sorted[part][r] * sorted[part][r];
+      }
+      double mean = result->ticks > 0 ? sum / result->ticks : 0;
+      double deviation = result->ticks > 0 ? sqrt(std::max(0.0, squares / result->ticks - mean * mean)) : 0;
+
+      printf("%4d  %-6s %7u %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", face, partNames[part], result->ticks,
+             percentile(sorted[part], 0) / 1e3, percentile(sorted[part], 0.5) / 1e3,
+             percentile(sorted[part], 0.9) / 1e3, percentile(sorted[part], 0.99) / 1e3,
+             percentile(sorted[part], 1) / 1e3, mean / 1e3, deviation / 1e3);
+    }
+
+    metrics[face][LATENCY_TOTAL_P50] = percentile(sorted[LATENCY_TOTAL], 0.5) / 1e3;
+    metrics[face][LATENCY_TOTAL_P99] = percentile(sorted[LATENCY_TOTAL], 0.99) / 1e3;
+    metrics[face][LATENCY_TOTAL_MAX] = percentile(sorted[LATENCY_TOTAL], 1) / 1e3;
+    metrics[face][LATENCY_DETECT_MAX] = percentile(sorted[LATENCY_DETECT], 1) / 1e3;
+
+    if (histogram) {
+      printHistogram(sorted[LATENCY_TOTAL]);
+    }
+  }
+  free(result);
+
+  int status = 0;
+
+  if (baselinePath != nullptr) {
+    double baseline[SIM_FACTORY_FACES][LATENCY_METRICS];
+    if (!readBaseline(baselinePath, baseline)) {
+      return 1;
+    }
+
+    for (int face = 0; face < SIM_FACTORY_FACES; face++) {
+      for (int m = 0; m < LATENCY_METRICS; m++) {
+        double limit = baseline[face][m] * (1.0 + tolerance / 100.0) + 0.0005;
+        if (metrics[face][m] > limit) {
+          printf("REGRESSION face %d %s: %.3f, baseline %.3f\n", face, metricNames[m], metrics[face][m], baseline[face][m]);
+          status = 1;
+        }
+      }
+    }
+    printf(status == 0 ? "Within %.1f%% of baseline\n" : "Regressed more than %.1f%% from baseline\n", tolerance);
+  }
+
+  if (writePath != nullptr && !writeBaseline(writePath, metrics)) {
+    return 1;
+  }
+  return status;
+}
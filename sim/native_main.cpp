@@ -0,0 +1,203 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Host-native entry point: runs the firmware setup() and loop() against the simulator HAL.
+//
+// Usage: program [options]
+//   --speed <factor>     Pace virtual time against the wall clock, 0 runs as fast as possible
+//                        (default 1).
+//   --seconds <n>        Stop after this many seconds of virtual time.
+//   --rtc-seconds <n>    Stop after the RTC has advanced this many seconds.
+//   --time <hh:mm:ss>    Start time of the RTC (default 10:08:00).
+//   --rtc-scale <n>      Run the RTC n times faster than virtual time.
+//   --rtc-skip           Jump the RTC to the next second edge on every poll.
+//   --factory            Start from factory settings instead of an erased EEPROM.
+//   --face <n>           Start with clock face n (implies --factory).
+//   --pic <revision>     PIC firmware revision: full (default), nowrap, basic or silent, see
+//                        pic_ring.h.
+//   --baud <rate>        Fastest baud rate the PIC keeps up with (default 115200).
+//   --atmega-reset       Start the firmware once before the run and keep the EEPROM and the
+//                        PIC baud rate it leaves, as a reset of the ATmega alone does.
+//   --show               Print the ring LEDs every time they change.
+//   --frames             Print every ring command frame with its wire time.
+//   --display            Print the 7-segment display every time it changes.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "sim_hal.h"
+#include "board.h"
+#include "firmware.h"
+
+static SimBoard board;
+static PicRingEmulator &pic = board.pic;
+static Ht16k33Emulator &segments = board.display;
+static Ds1307Emulator &rtc = board.rtc;
+
+//  What a first start of the firmware leaves behind for --atmega-reset.
+struct NativeFirstStart {
+  uint8_t eeprom[SIM_EEPROM_SIZE];
+  unsigned long baud;
+};
+
+static void runFirstStart(void *arg, void *result) {
+  NativeFirstStart &left = *(NativeFirstStart *)result;
+  setup();
+  memcpy(left.eeprom, simEeprom(), SIM_EEPROM_SIZE);
+  left.baud = pic.baudRate();
+}
+
+static void printFrames(size_t from) {
+  const std::vector<PicFrame> &frames = pic.frames();
+  for (size_t r = from; r < frames.size(); r++) {
+    printf("%12.3f ms %8.3f ms ", frames[r].startNanos / 1e6, (frames[r].endNanos - frames[r].startNanos) / 1e6);
+    for (uint8_t b = 0; b < frames[r].length; b++) {
+      printf(" %02X", frames[r].bytes[b]);
+    }
+    if (frames[r].error != PIC_FRAME_OK) {
+      printf("  <- %s", PicRingEmulator::errorName(frames[r].error));
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char **argv) {
+  double speed = 1.0;
+  double seconds = 0;
+  bool show = false;
+  bool showFrames = false;
+  bool showDisplay = false;
+  double rtcSeconds = 0;
+  unsigned int startHours = 10, startMinutes = 8, startSeconds = 0;
+  double rtcScale = 1.0;
+  bool rtcSkip = false;
+  bool factory = false;
+  int face = -1;
+  uint8_t features = PIC_FEATURES_ALL;
+  unsigned long baudLimit = 115200;
+  bool atmegaReset = false;
+
+  for (int r = 1; r < argc; r++) {
+    if (strcmp(argv[r], "--speed") == 0 && r + 1 < argc) {
+      speed = atof(argv[++r]);
+    } else if (strcmp(argv[r], "--seconds") == 0 && r + 1 < argc) {
+      seconds = atof(argv[++r]);
+    } else if (strcmp(argv[r], "--atmega-reset") == 0) {
+      atmegaReset = true;
+    } else if (strcmp(argv[r], "--show") == 0) {
+      show = true;
+    } else if (strcmp(argv[r], "--frames") == 0) {
+      showFrames = true;
+    } else if (strcmp(argv[r], "--display") == 0) {
+      showDisplay = true;
+    } else if (strcmp(argv[r], "--rtc-seconds") == 0 && r + 1 < argc) {
+      rtcSeconds = atof(argv[++r]);
+    } else if (strcmp(argv[r], "--time") == 0 && r + 1 < argc &&
+               sscanf(argv[r + 1], "%u:%u:%u", &startHours, &startMinutes, &startSeconds) == 3) {
+      r++;
+    } else if (strcmp(argv[r], "--rtc-scale") == 0 && r + 1 < argc) {
+      rtcScale = atof(argv[++r]);
+    } else if (strcmp(argv[r], "--rtc-skip") == 0) {
+      rtcSkip = true;
+    } else if (strcmp(argv[r], "--factory") == 0) {
+      factory = true;
+    } else if (strcmp(argv[r], "--face") == 0 && r + 1 < argc) {
+      face = atoi(argv[++r]);
+      factory = true;
+    } else if (strcmp(argv[r], "--pic") == 0 && r + 1 < argc && PicRingEmulator::parseFeatures(argv[r + 1], features)) {
+      r++;
+    } else if (strcmp(argv[r], "--baud") == 0 && r + 1 < argc && PicRingEmulator::parseBaud(argv[r + 1], baudLimit)) {
+      r++;
+    } else {
+      fprintf(stderr, "Usage: %s [--speed <factor>] [--seconds <n>] [--rtc-seconds <n>] [--time <hh:mm:ss>]\n"
+                      "          [--rtc-scale <n>] [--rtc-skip] [--factory] [--face <n>] [--pic <revision>]\n"
+                      "          [--baud <rate>] [--atmega-reset] [--show] [--frames] [--display]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  board.powerOn();
+  pic.setFeatures(features);
+  pic.setBaudLimit(baudLimit);
+  simSetPacing(speed);
+
+  rtc.setDateTime(20, 1, 1, 4, startHours, startMinutes, startSeconds);
+  rtc.setTimeScale(rtcScale);
+  rtc.setSkipToEdge(rtcSkip);
+
+  if (factory) {
+    board.loadFactorySettings(face);
+  }
+
+  if (atmegaReset) {
+    //  The firmware keeps its state in globals, so the first start runs in a process of its own
+    NativeFirstStart left;
+    if (!simRunIsolated(runFirstStart, nullptr, &left, sizeof(left))) {
+      fprintf(stderr, "First start failed\n");
+      return 1;
+    }
+    memcpy(simEeprom(), left.eeprom, SIM_EEPROM_SIZE);
+    pic.setBaudRate(left.baud);
+  }
+
+  uint64_t endNanos = (uint64_t)(seconds * 1e9);
+  size_t printedFrames = 0;
+  uint8_t shownRam[HT16K33_RAM_SIZE] = {0};
+
+  setup();
+  while ((endNanos == 0 || simNanos() < endNanos) && (rtcSeconds == 0 || rtc.edges() < rtcSeconds)) {
+    loop();
+
+    if (pic.frames().size() != printedFrames) {
+      if (showFrames) {
+        printFrames(printedFrames);
+      }
+      if (show) {
+        printf("%.3f s\n", simNanos() / 1e9);
+        pic.print(stdout);
+      }
+      //  Keep memory bounded on long runs, the totals are kept in the stats.
+      pic.clearFrames();
+      printedFrames = 0;
+    }
+
+    if (memcmp(shownRam, segments.displayRam(), HT16K33_RAM_SIZE) != 0) {
+      memcpy(shownRam, segments.displayRam(), HT16K33_RAM_SIZE);
+      if (showDisplay) {
+        printf("%.3f s ", simNanos() / 1e9);
+        segments.print(stdout);
+      }
+    }
+    segments.clearTransactions();
+  }
+
+  simAdvanceTo(simUartIdleNanos());
+  pic.finish();
+  if (showFrames) {
+    printFrames(printedFrames);
+  }
+
+  const PicRingStats &stats = pic.stats();
+  printf("Ran %.3f s virtual time, %llu s RTC time\n", simNanos() / 1e9, (unsigned long long)rtc.edges());
+  printf("Ring link: %llu bytes, %llu frames, %llu malformed, %llu ignored, %.3f ms on the wire at %lu baud\n",
+         (unsigned long long)stats.bytes,
+         (unsigned long long)stats.frames,
+         (unsigned long long)stats.malformed,
+         (unsigned long long)stats.ignored,
+         stats.wireNanos / 1e6,
+         simUartBaud());
+  printf("Ring link errors: %llu overruns, %llu misclocked, %u echo timeouts, %u unexpected echoes\n",
+         (unsigned long long)stats.overruns, (unsigned long long)stats.misclocked, ringLinkTimeouts, ringLinkErrors);
+  const Ht16k33Stats &display = segments.stats();
+  printf("HT16K33: %llu transactions, %llu bytes, %.3f ms on the bus, %.3f ms per second\n",
+         (unsigned long long)display.transactions,
+         (unsigned long long)display.bytes,
+         display.busNanos / 1e6,
+         simNanos() > 0 ? display.busNanos / 1e6 / (simNanos() / 1e9) : 0.0);
+  printf("I2C: %llu bytes\n", (unsigned long long)simI2cBytesTransferred());
+  return 0;
+}
@@ -0,0 +1,391 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the PIC ring controller, see pic_ring.h.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pic_ring.h"
+
+//  PIC commands, the same values as RING_CMD_* in src/main.cpp
+#define PIC_CMD_ON_OFF_LEDS   0xF1
+#define PIC_CMD_MOVE_FORWARD  0xF2
+#define PIC_CMD_MOVE_REVERSE  0xF3
+#define PIC_CMD_METER_LEDS    0xF4
+#define PIC_CMD_OFF_LEDS      0xF5
+#define PIC_CMD_OFF_ALL_LEDS  0xF6
+#define PIC_CMD_SET_BAUD      0xF7
+#define PIC_CMD_END           0x03
+#define PIC_BYTE_UNUSED       0x00
+
+//  Ring selection bits in the second byte of a frame
+#define PIC_BIT_SECONDS 0x01
+#define PIC_BIT_MINUTES 0x02
+#define PIC_BIT_HOURS   0x04
+
+uint8_t picFrameLength(uint8_t command) {
+  switch (command) {
+    case PIC_CMD_ON_OFF_LEDS:
+    case PIC_CMD_MOVE_FORWARD:
+    case PIC_CMD_MOVE_REVERSE:
+    case PIC_CMD_OFF_LEDS:
+    case PIC_CMD_OFF_ALL_LEDS:
+    case PIC_CMD_SET_BAUD:
+      return 5;
+    case PIC_CMD_METER_LEDS:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+unsigned long picBaudRate(uint8_t index) {
+  static const unsigned long rates[PIC_BAUD_RATES] = {9600, 19200, 38400, 57600, 115200};
+  return index < PIC_BAUD_RATES ? rates[index] : 0;
+}
+
+char picColorChar(uint8_t color) {
+  static const char chars[] = ".rgobpcw";
+  return color < 8 ? chars[color] : '?';
+}
+
+//  ====================================================================================
+
+PicRingEmulator::PicRingEmulator() {
+  recording = true;
+  features = PIC_FEATURES_ALL;
+  echoSink = simUartInject;
+  baudLimit = picBaudRate(PIC_BAUD_RATES - 1);
+  reset();
+}
+
+void PicRingEmulator::reset() {
+  memset(leds, 0, sizeof(leds));
+  memset(&current, 0, sizeof(current));
+  memset(&totals, 0, sizeof(totals));
+  byteNanos = 0;
+  busyUntil = 0;
+  heldUntil = 0;
+  baud = picBaudRate(0);
+  trialBaud = 0;
+  trialUntil = 0;
+  recorded.clear();
+}
+
+void PicRingEmulator::uartReceive(uint8_t data, uint64_t startNanos, uint64_t endNanos) {
+  totals.bytes++;
+  totals.wireNanos += endNanos - startNanos;
+  byteNanos = endNanos - startNanos;
+
+  if (trialBaud != 0 && startNanos >= trialUntil) {
+    //  No frame came at the new rate, go back to the one that worked.
+    baud = trialBaud;
+    trialBaud = 0;
+  }
+
+  //  A UART samples mid-bit, a few percent off the rate still decodes.
+  uint64_t expected = 10ULL * 1000000000ULL / baud;
+  uint64_t offBy = byteNanos > expected ? byteNanos - expected : expected - byteNanos;
+  if (offBy * 100 > expected * PIC_BAUD_TOLERANCE_PERCENT || baud > baudLimit) {
+    totals.misclocked++;
+    return;
+  }
+
+  if (endNanos < heldUntil) {
+    //  Both buffers are taken, the byte is lost.
+    totals.overruns++;
+    return;
+  }
+
+  if (current.length > 0) {
+    uint8_t expected = picFrameLength(current.bytes[0]);
+
+    if (current.length == expected - 1) {
+      if (data == PIC_CMD_END) {
+        current.bytes[current.length++] = data;
+        current.endNanos = endNanos;
+        complete(validate());
+        return;
+      }
+      complete(PIC_FRAME_MISSING_END);
+    } else if (picFrameLength(data) != 0) {
+      //  A command byte can never be a parameter, so the previous frame was cut short.
+      complete(PIC_FRAME_TRUNCATED);
+    } else {
+      current.bytes[current.length++] = data;
+      current.endNanos = endNanos;
+      return;
+    }
+  }
+
+  current.bytes[0] = data;
+  current.length = 1;
+  current.startNanos = startNanos;
+  current.endNanos = endNanos;
+
+  if (picFrameLength(data) == 0) {
+    complete(PIC_FRAME_STRAY_BYTE);
+  }
+}
+
+void PicRingEmulator::finish() {
+  if (current.length > 0) {
+    complete(PIC_FRAME_TRUNCATED);
+  }
+}
+
+void PicRingEmulator::complete(uint8_t error) {
+  if (error == PIC_FRAME_OK && current.bytes[0] != PIC_CMD_SET_BAUD) {
+    trialBaud = 0;
+  }
+
+  if (error == PIC_FRAME_OK) {
+    //  The frame waits in the receive buffer until the previous one is carried out.
+    heldUntil = current.endNanos > busyUntil ? current.endNanos : busyUntil;
+    busyUntil = heldUntil + PIC_ECHO_DELAY_NANOS;
+  }
+
+  if (error == PIC_FRAME_OK && !supported()) {
+    totals.ignored++;
+  } else if (error == PIC_FRAME_OK) {
+    busyUntil += ledsWritten() * PIC_LED_NANOS;
+    apply();
+    if (features & PIC_FEATURE_ECHO) {
+      echoSink(current.bytes[0], busyUntil + byteNanos);
+    }
+    if (current.bytes[0] == PIC_CMD_SET_BAUD) {
+      //  The echo still goes out at the old rate.
+      trialBaud = baud;
+      trialUntil = busyUntil + byteNanos + PIC_BAUD_TRIAL_NANOS;
+      baud = picBaudRate(current.bytes[2]);
+    }
+  } else {
+    totals.malformed++;
+  }
+  totals.frames++;
+
+  current.error = error;
+  if (recording) {
+    recorded.push_back(current);
+  }
+  current.length = 0;
+}
+
+bool PicRingEmulator::supported() const {
+  switch (current.bytes[0]) {
+    case PIC_CMD_METER_LEDS:
+      if (current.bytes[2] > current.bytes[3] && (features & PIC_FEATURE_WRAP) == 0) {
+        return false;
+      }
+      return (features & PIC_FEATURE_METER) != 0;
+    case PIC_CMD_MOVE_FORWARD:
+    case PIC_CMD_MOVE_REVERSE:
+      return (features & PIC_FEATURE_MOVE) != 0;
+    case PIC_CMD_SET_BAUD:
+      return (features & PIC_FEATURE_BAUD) != 0;
+    default:
+      return true;
+  }
+}
+
+uint16_t PicRingEmulator::ledsWritten() const {
+  uint8_t rings = 0;
+  for (uint8_t bit = PIC_BIT_SECONDS; bit <= PIC_BIT_HOURS; bit <<= 1) {
+    if (current.bytes[1] & bit) {
+      rings++;
+    }
+  }
+
+  switch (current.bytes[0]) {
+    case PIC_CMD_ON_OFF_LEDS:
+      return rings;
+    case PIC_CMD_METER_LEDS:
+      return rings * ((current.bytes[3] + PIC_RING_POSITIONS - current.bytes[2]) % PIC_RING_POSITIONS + 1);
+    case PIC_CMD_OFF_ALL_LEDS:
+      return PIC_RING_COUNT * PIC_RING_POSITIONS;
+    case PIC_CMD_SET_BAUD:
+      return 0;
+    default:
+      return rings * PIC_RING_POSITIONS;
+  }
+}
+
+uint8_t PicRingEmulator::validate() const {
+  uint8_t command = current.bytes[0];
+  uint8_t rings = current.bytes[1];
+
+  //  An unused byte must be 0, an older PIC may read it as a ring or parameter
+  if (command == PIC_CMD_SET_BAUD) {
+    if (current.bytes[1] != PIC_BYTE_UNUSED || current.bytes[3] != PIC_BYTE_UNUSED) {
+      return PIC_FRAME_BAD_UNUSED;
+    }
+    return current.bytes[2] < PIC_BAUD_RATES ? PIC_FRAME_OK : PIC_FRAME_BAD_RATE;
+  }
+  if (command == PIC_CMD_OFF_ALL_LEDS && current.bytes[1] != PIC_BYTE_UNUSED) {
+    return PIC_FRAME_BAD_UNUSED;
+  }
+  if ((command == PIC_CMD_OFF_LEDS || command == PIC_CMD_OFF_ALL_LEDS) && current.bytes[2] != PIC_BYTE_UNUSED) {
+    return PIC_FRAME_BAD_UNUSED;
+  }
+  if ((command == PIC_CMD_MOVE_FORWARD || command == PIC_CMD_MOVE_REVERSE || command == PIC_CMD_OFF_LEDS ||
+       command == PIC_CMD_OFF_ALL_LEDS) && current.bytes[3] != PIC_BYTE_UNUSED) {
+    return PIC_FRAME_BAD_UNUSED;
+  }
+  if (command != PIC_CMD_OFF_ALL_LEDS && (rings == 0 || rings > 7)) {
+    return PIC_FRAME_BAD_RING;
+  }
+
+  if (command == PIC_CMD_ON_OFF_LEDS) {
+    if (current.bytes[2] >= PIC_RING_POSITIONS) {
+      return PIC_FRAME_BAD_POSITION;
+    }
+    if (current.bytes[3] > 7) {
+      return PIC_FRAME_BAD_COLOR;
+    }
+  } else if (command == PIC_CMD_METER_LEDS) {
+    if (current.bytes[2] >= PIC_RING_POSITIONS || current.bytes[3] >= PIC_RING_POSITIONS) {
+      return PIC_FRAME_BAD_POSITION;
+    }
+    if (current.bytes[4] > 7) {
+      return PIC_FRAME_BAD_COLOR;
+    }
+  }
+  return PIC_FRAME_OK;
+}
+
+void PicRingEmulator::apply() {
+  uint8_t rings = current.bytes[1];
+
+  switch (current.bytes[0]) {
+    case PIC_CMD_ON_OFF_LEDS:
+      setLeds(rings, current.bytes[2], current.bytes[3]);
+      break;
+
+    case PIC_CMD_MOVE_FORWARD:
+      rotate(rings, 1, current.bytes[2]);
+      break;
+
+    case PIC_CMD_MOVE_REVERSE:
+      rotate(rings, -1, current.bytes[2]);
+      break;
+
+    case PIC_CMD_METER_LEDS: {
+      //  Fill clockwise from start to end, wrapping past position 59.
+      uint8_t position = current.bytes[2];
+      while (true) {
+        setLeds(rings, position, current.bytes[4]);
+        if (position == current.bytes[3]) {
+          break;
+        }
+        position = (position + 1) % PIC_RING_POSITIONS;
+      }
+      break;
+    }
+
+    case PIC_CMD_OFF_LEDS:
+      for (uint8_t r = 0; r < PIC_RING_POSITIONS; r++) {
+        setLeds(rings, r, 0);
+      }
+      break;
+
+    case PIC_CMD_OFF_ALL_LEDS:
+      memset(leds, 0, sizeof(leds));
+      break;
+  }
+}
+
+void PicRingEmulator::setLeds(uint8_t rings, uint8_t position, uint8_t color) {
+  if (rings & PIC_BIT_HOURS) {
+    leds[PIC_RING_HOURS][position] = color;
+  }
+  if (rings & PIC_BIT_MINUTES) {
+    leds[PIC_RING_MINUTES][position] = color;
+  }
+  if (rings & PIC_BIT_SECONDS) {
+    leds[PIC_RING_SECONDS][position] = color;
+  }
+}
+
+void PicRingEmulator::rotate(uint8_t rings, int8_t direction, uint8_t count) {
+  static const uint8_t bits[PIC_RING_COUNT] = {PIC_BIT_HOURS, PIC_BIT_MINUTES, PIC_BIT_SECONDS};
+  uint8_t shift = count % PIC_RING_POSITIONS;
+  if (direction < 0) {
+    shift = (PIC_RING_POSITIONS - shift) % PIC_RING_POSITIONS;
+  }
+
+  for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+    if (rings & bits[ring]) {
+      uint8_t moved[PIC_RING_POSITIONS];
+      for (uint8_t r = 0; r < PIC_RING_POSITIONS; r++) {
+        moved[(r + shift) % PIC_RING_POSITIONS] = leds[ring][r];
+      }
+      memcpy(leds[ring], moved, sizeof(moved));
+    }
+  }
+}
+
+//  ====================================================================================
+
+void PicRingEmulator::print(FILE *out) const {
+  static const char *names[PIC_RING_COUNT] = {"H", "M", "S"};
+  for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+    fprintf(out, "%s ", names[ring]);
+    for (uint8_t r = 0; r < PIC_RING_POSITIONS; r++) {
+      fputc(picColorChar(leds[ring][r]), out);
+    }
+    fputc('\n', out);
+  }
+}
+
+bool PicRingEmulator::parseFeatures(const char *name, uint8_t &enabled) {
+  if (strcmp(name, "full") == 0) {
+    enabled = PIC_FEATURES_ALL;
+  } else if (strcmp(name, "nowrap") == 0) {
+    enabled = PIC_FEATURES_ALL & ~PIC_FEATURE_WRAP;
+  } else if (strcmp(name, "basic") == 0) {
+    enabled = PIC_FEATURE_ECHO;
+  } else if (strcmp(name, "silent") == 0) {
+    enabled = 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool PicRingEmulator::parseBaud(const char *text, unsigned long &rate) {
+  unsigned long value = strtoul(text, nullptr, 10);
+  for (uint8_t index = 0; index < PIC_BAUD_RATES; index++) {
+    if (picBaudRate(index) == value) {
+      rate = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *PicRingEmulator::errorName(uint8_t error) {
+  switch (error) {
+    case PIC_FRAME_OK:
+      return "ok";
+    case PIC_FRAME_MISSING_END:
+      return "missing end";
+    case PIC_FRAME_STRAY_BYTE:
+      return "stray byte";
+    case PIC_FRAME_BAD_RING:
+      return "bad ring";
+    case PIC_FRAME_BAD_POSITION:
+      return "bad position";
+    case PIC_FRAME_BAD_COLOR:
+      return "bad color";
+    case PIC_FRAME_TRUNCATED:
+      return "truncated";
+    case PIC_FRAME_BAD_RATE:
+      return "bad rate";
+    case PIC_FRAME_BAD_UNUSED:
+      return "unused byte set";
+    default:
+      return "?";
+  }
+}
@@ -0,0 +1,175 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Emulator of the PIC that multiplexes the 3×60 ring LEDs.
+//
+// Decodes the command stream the firmware writes on the UART (see the command list at the top
+// of src/main.cpp) into hours, minutes and seconds ring state. Every frame is recorded with
+// the wire time of its first and last byte, and frames that do not follow the protocol are
+// flagged instead of applied:
+//
+//  0xF1, rings, position, color, 0x03              Set one LED
+//  0xF2, rings, count, unused, 0x03                Move pattern forward (clockwise)
+//  0xF3, rings, count, unused, 0x03                Move pattern reverse (counter-clockwise)
+//  0xF4, rings, start, end, color, 0x03            Meter, fill start..end inclusive
+//  0xF5, rings, unused, unused, 0x03               Turn off all LEDs in the rings
+//  0xF6, unused, unused, unused, 0x03              Turn off all LEDs
+//  0xF7, unused, rate, unused, 0x03                Change baud rate after the echo (proposed)
+//
+// The PIC firmware revision is chosen with setFeatures(). By default the emulator takes every
+// command and echoes the command byte of each frame it carries out back on the UART, which is
+// what the firmware probes at start up. A revision without the meter or move commands ignores
+// those frames without an echo, and one without the echo never answers. A revision that only
+// fills meters from a start up to a later end ignores meter frames that wrap past position 59.
+//
+// The PIC carries out one frame while it receives the next into a second buffer. A byte that
+// arrives while a complete frame still waits in that buffer is lost as an overrun, which the
+// firmware avoids by keeping no more frames in flight than the echoes allow.
+//
+// The PIC starts at 9600 baud. After a change of rate it goes back to the previous one unless a
+// good frame arrives within 100 ms. Bytes sent at another rate than the PIC's, or faster than
+// the fastest rate it keeps up with (setBaudLimit()), are lost as misclocked.
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CLOCKOS_SIM_PIC_RING_H
+#define CLOCKOS_SIM_PIC_RING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+#include "sim_hal.h"
+
+#define PIC_RING_COUNT      3
+#define PIC_RING_POSITIONS  60
+#define PIC_FRAME_MAX       6
+
+//  Ring indexes of the emulated LED state.
+#define PIC_RING_HOURS    0
+#define PIC_RING_MINUTES  1
+#define PIC_RING_SECONDS  2
+
+//  Reasons for flagging a frame as malformed.
+#define PIC_FRAME_OK              0
+#define PIC_FRAME_MISSING_END     1
+#define PIC_FRAME_STRAY_BYTE      2
+#define PIC_FRAME_BAD_RING        3
+#define PIC_FRAME_BAD_POSITION    4
+#define PIC_FRAME_BAD_COLOR       5
+#define PIC_FRAME_TRUNCATED       6
+#define PIC_FRAME_BAD_RATE        7
+#define PIC_FRAME_BAD_UNUSED      8
+
+//  Features of the emulated PIC firmware revision.
+#define PIC_FEATURE_ECHO    0x01
+#define PIC_FEATURE_METER   0x02
+#define PIC_FEATURE_MOVE    0x04
+#define PIC_FEATURE_BAUD    0x08
+#define PIC_FEATURE_WRAP    0x10
+#define PIC_FEATURES_ALL    (PIC_FEATURE_ECHO | PIC_FEATURE_METER | PIC_FEATURE_MOVE | PIC_FEATURE_BAUD | PIC_FEATURE_WRAP)
+
+//  Baud rates of the set baud command, the first one is the rate after power on.
+#define PIC_BAUD_RATES        5
+#define PIC_BAUD_TRIAL_NANOS  100000000ULL
+#define PIC_BAUD_TOLERANCE_PERCENT 3
+
+//  Time the PIC takes to carry out a frame before it starts sending the echo, plus the time
+//  per LED the frame writes.
+#define PIC_ECHO_DELAY_NANOS 100000ULL
+#define PIC_LED_NANOS        5000ULL
+
+struct PicFrame {
+  uint8_t bytes[PIC_FRAME_MAX];
+  uint8_t length;
+  uint8_t error;
+  uint64_t startNanos;
+  uint64_t endNanos;
+};
+
+//  Receives an echo byte with the time its stop bit is on the wire, simUartInject() by default.
+typedef void (*PicEchoSink)(uint8_t data, uint64_t atNanos);
+
+struct PicRingStats {
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t malformed;
+  uint64_t ignored;
+  uint64_t overruns;
+  uint64_t misclocked;
+  uint64_t wireNanos;
+};
+
+class PicRingEmulator : public SimUartPeer {
+  public:
+    PicRingEmulator();
+
+    void reset();
+    void setRecording(bool enabled) { recording = enabled; }
+
+    //  Selects the firmware revision by its PIC_FEATURE_ bits, kept over reset().
+    void setFeatures(uint8_t enabled) { features = enabled; }
+    uint8_t featureBits() const { return features; }
+    void setEchoSink(PicEchoSink sink) { echoSink = sink; }
+
+    //  Fastest baud rate the PIC keeps up with, kept over reset().
+    void setBaudLimit(unsigned long rate) { baudLimit = rate; }
+    unsigned long baudRate() const { return baud; }
+
+    //  Sets the rate the PIC is at, as a reset of the ATmega alone leaves it.
+    void setBaudRate(unsigned long rate) { baud = rate; trialBaud = 0; }
+    static bool parseBaud(const char *text, unsigned long &rate);
+
+    //  Parses a revision name: full, nowrap (full without wrapping meters), basic (echo only) or
+    //  silent (basic without echo).
+    static bool parseFeatures(const char *name, uint8_t &enabled);
+
+    void uartReceive(uint8_t data, uint64_t startNanos, uint64_t endNanos) override;
+
+    //  Flags a partially received frame at the end of a run.
+    void finish();
+
+    uint8_t led(uint8_t ring, uint8_t position) const { return leds[ring][position]; }
+    const uint8_t *ring(uint8_t ring) const { return leds[ring]; }
+
+    const PicRingStats &stats() const { return totals; }
+    const std::vector<PicFrame> &frames() const { return recorded; }
+    void clearFrames() { recorded.clear(); }
+
+    void print(FILE *out) const;
+    static const char *errorName(uint8_t error);
+
+  private:
+    void complete(uint8_t error);
+    uint8_t validate() const;
+    bool supported() const;
+    uint16_t ledsWritten() const;
+    void apply();
+    void setLeds(uint8_t rings, uint8_t position, uint8_t color);
+    void rotate(uint8_t rings, int8_t direction, uint8_t count);
+
+    uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS];
+    PicFrame current;
+    bool recording;
+    uint8_t features;
+    PicEchoSink echoSink;
+    uint64_t byteNanos;
+    uint64_t busyUntil;
+    uint64_t heldUntil;
+    unsigned long baud;
+    unsigned long baudLimit;
+    unsigned long trialBaud;
+    uint64_t trialUntil;
+    PicRingStats totals;
+    std::vector<PicFrame> recorded;
+};
+
+//  Baud rate of a set baud command rate index.
+unsigned long picBaudRate(uint8_t index);
+
+//  Expected frame length for a command byte, 0 if it is not a command.
+uint8_t picFrameLength(uint8_t command);
+
+//  Character used when printing an LED color.
+char picColorChar(uint8_t color);
+
+#endif
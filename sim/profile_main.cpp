@@ -0,0 +1,417 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Function profile of the firmware: runs every factory clock face with face switches and a pass
+// through each menu, and reports per function of src/main.cpp how often it is called, how deep
+// in the call stack and how much host time it takes.
+//
+// Usage: program [--ticks <n>] [--face <n>] [--top <n>]
+//   --ticks   Seconds per face drawn in normal mode (default 600).
+//   --face    Only run this face.
+//   --top     Number of functions listed, by host time (default 40, 0 for all).
+//
+// The firmware is built with -finstrument-functions (see the profile environment in
+// platformio.ini), so every call of a firmware function, inlined or not, passes through the
+// hooks below. Nothing in sim/ is instrumented, the HAL and the emulators count towards the
+// firmware function that called them.
+//
+// A tick is one pass of loop() in normal mode, and each menu counts as one tick from the key
+// press that opens it until it is left, so the worst calls per tick come from the menus or the
+// face switches.
+//
+// Call counts and call depths carry over to the ATmega168 as they are. The host time does not
+// translate into AVR cycles, it only ranks the functions against each other, and includes the
+// hooks themselves and the emulated peripherals. The host stack of the deepest call chain is
+// only a pointer to where the AVR stack peaks, frames there are much smaller.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <algorithm>
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "board.h"
+#include "firmware.h"
+
+#define PROFILE_DEFAULT_TICKS   600
+#define PROFILE_DEFAULT_TOP     40
+#define PROFILE_FUNCTIONS       256
+#define PROFILE_DEPTH           64
+#define PROFILE_SWITCH_TICKS    60
+#define PROFILE_IDLE_MILLIS     100
+#define PROFILE_KEY_DOWN_MILLIS 400
+#define PROFILE_KEY_UP_MILLIS   400
+#define PROFILE_MENU_MILLIS     600000
+
+#define PROFILE_PIN_BUTTON1     8
+#define PROFILE_PIN_BUTTON2     9
+#define PROFILE_PIN_BUTTON3     10
+
+//  Modes of the menu, as in src/main.cpp.
+#define PROFILE_MODE_NORMAL     0
+#define PROFILE_MENUS           3
+
+struct ProfileFunction {
+  void *address;
+  unsigned long long calls;
+  unsigned long long nanos;
+  unsigned long long tickCalls;
+  unsigned long long worstTickCalls;
+  unsigned int deepest;
+  unsigned int stackBytes;
+};
+
+struct ProfileResult {
+  ProfileFunction functions[PROFILE_FUNCTIONS];
+  unsigned int count;
+  unsigned long long ticks;
+  unsigned int chain[PROFILE_DEPTH];
+  unsigned int chainLength;
+  unsigned int chainStackBytes;
+  bool overflow;
+  bool stuck;
+};
+
+//  Open calls, innermost last.
+struct ProfileFrame {
+  unsigned int function;
+  unsigned long long startNanos;
+};
+
+static ProfileResult *profile = nullptr;
+static ProfileFrame frames[PROFILE_DEPTH];
+static unsigned int depth = 0;
+static char *stackBase = nullptr;
+
+static SimBoard board;
+static unsigned long ticks = PROFILE_DEFAULT_TICKS;
+
+extern "C" {
+void __cyg_profile_func_enter(void *function, void *site) __attribute__((no_instrument_function));
+void __cyg_profile_func_exit(void *function, void *site) __attribute__((no_instrument_function));
+}
+
+static unsigned long long hostNanos() __attribute__((no_instrument_function));
+static unsigned long long hostNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static unsigned int profileIndex(void *function) __attribute__((no_instrument_function));
+static unsigned int profileIndex(void *function) {
+  for (unsigned int r = 0; r < profile->count; r++) {
+    if (profile->functions[r].address == function) {
+      return r;
+    }
+  }
+  if (profile->count == PROFILE_FUNCTIONS) {
+    profile->overflow = true;
+    return PROFILE_FUNCTIONS - 1;
+  }
+  profile->functions[profile->count].address = function;
+  return profile->count++;
+}
+
+void __cyg_profile_func_enter(void *function, void *site) {
+  if (profile == nullptr) {
+    return;
+  }
+  char *stack = (char *)__builtin_frame_address(0);
+  if (depth == 0) {
+    stackBase = stack;
+  }
+
+  unsigned int index = profileIndex(function);
+  ProfileFunction &entry = profile->functions[index];
+  entry.calls++;
+  entry.tickCalls++;
+  if (depth + 1 > entry.deepest) {
+    entry.deepest = depth + 1;
+  }
+  unsigned int stackBytes = stackBase - stack;
+  if (stackBytes > entry.stackBytes) {
+    entry.stackBytes = stackBytes;
+  }
+
+  if (depth == PROFILE_DEPTH) {
+    profile->overflow = true;
+    return;
+  }
+  frames[depth].function = index;
+  depth++;
+  if (depth > profile->chainLength) {
+    profile->chainLength = depth;
+    profile->chainStackBytes = stackBytes;
+    for (unsigned int r = 0; r < depth; r++) {
+      profile->chain[r] = frames[r].function;
+    }
+  }
+  frames[depth - 1].startNanos = hostNanos();
+}
+
+void __cyg_profile_func_exit(void *function, void *site) {
+  if (profile == nullptr || depth == 0) {
+    return;
+  }
+  depth--;
+  ProfileFrame &frame = frames[depth];
+  profile->functions[frame.function].nanos += hostNanos() - frame.startNanos;
+}
+
+//  Keeps the most calls of each function in one tick.
+static void profileTick() {
+  for (unsigned int r = 0; r < profile->count; r++) {
+    ProfileFunction &entry = profile->functions[r];
+    entry.worstTickCalls = std::max(entry.worstTickCalls, entry.tickCalls);
+    entry.tickCalls = 0;
+  }
+  profile->ticks++;
+}
+
+//  Key presses played back in virtual time from delay() and before every loop(): a button
+//  number per press, and while repeatEnter is set button 2 again until the menu is left.
+static const char *keyScript = nullptr;
+static bool keyRepeatEnter = false;
+static bool keyDown = false;
+static uint64_t keyNextNanos = 0;
+
+static bool menuOpen() {
+  return mode != PROFILE_MODE_NORMAL;
+}
+
+static void releaseKeys() {
+  simSetPin(PROFILE_PIN_BUTTON1, HIGH);
+  simSetPin(PROFILE_PIN_BUTTON2, HIGH);
+  simSetPin(PROFILE_PIN_BUTTON3, HIGH);
+}
+
+static void playKeys() {
+  if (simNanos() < keyNextNanos) {
+    return;
+  }
+  if (keyDown) {
+    releaseKeys();
+    keyDown = false;
+    keyNextNanos = simNanos() + PROFILE_KEY_UP_MILLIS * 1000000ULL;
+    return;
+  }
+
+  char key = 0;
+  if (keyScript != nullptr && *keyScript != 0) {
+    key = *keyScript++;
+  } else if (keyRepeatEnter && menuOpen()) {
+    key = '2';
+  }
+  if (key == 0) {
+    return;
+  }
+  simSetPin(key == '1' ? PROFILE_PIN_BUTTON1 : key == '2' ? PROFILE_PIN_BUTTON2 : PROFILE_PIN_BUTTON3, LOW);
+  keyDown = true;
+  keyNextNanos = simNanos() + PROFILE_KEY_DOWN_MILLIS * 1000000ULL;
+}
+
+static void delayHook(unsigned long ms) {
+  playKeys();
+}
+
+static bool keysPlaying() {
+  return keyDown || (keyScript != nullptr && *keyScript != 0) || (keyRepeatEnter && menuOpen());
+}
+
+//  Opens menu 1 to 3 from normal mode and steps through all of its settings with button 2.
+static bool runMenu(int menu) {
+  static const char *scripts[PROFILE_MENUS] = { "212", "2112", "21112" };
+  keyScript = scripts[menu - 1];
+  keyRepeatEnter = true;
+
+  uint64_t endNanos = simNanos() + PROFILE_MENU_MILLIS * 1000000ULL;
+  while (keysPlaying() && simNanos() < endNanos) {
+    playKeys();
+    loop();
+
+    //  The menus run inside loop(), let go of the key that left them before normal mode sees it
+    if (*keyScript == 0 && !menuOpen()) {
+      break;
+    }
+    delay(1);
+  }
+  keyRepeatEnter = false;
+  keyDown = false;
+  releaseKeys();
+  return simNanos() < endNanos;
+}
+
+static void runFace(void *arg, void *output) {
+  int face = *(int *)arg;
+  profile = (ProfileResult *)output;
+  memset(profile, 0, sizeof(*profile));
+
+  board.powerOn();
+  board.loadFactorySettings(face);
+  board.pic.setRecording(false);
+  board.display.setRecording(false);
+  simSetDelayHook(delayHook);
+
+  setup();
+  board.rtc.setDateTime(19, 12, 31, 3, 23, 59, 59);
+  board.rtc.setSkipToEdge(true);
+  profileTick();
+
+  uint64_t startEdges = board.rtc.edges();
+  while (board.rtc.edges() - startEdges < ticks) {
+    uint64_t edges = board.rtc.edges() - startEdges;
+    if (edges > 0 && edges % PROFILE_SWITCH_TICKS == 0 && keyScript == nullptr) {
+      keyScript = "3";
+    }
+    playKeys();
+    loop();
+    ringFrameFlushAndWait();
+    profileTick();
+    if (keyScript != nullptr && !keysPlaying()) {
+      keyScript = nullptr;
+    }
+
+    //  The RTC jumps to the next edge on every read, as in the bus-traffic benchmark
+    delay(PROFILE_IDLE_MILLIS);
+  }
+
+  for (int menu = 1; menu <= PROFILE_MENUS; menu++) {
+    if (!runMenu(menu)) {
+      profile->stuck = true;
+    }
+    profileTick();
+  }
+  profile = nullptr;
+}
+
+//  Name of a firmware function without its parameter list.
+static void functionName(void *address, char *name, size_t size) {
+  Dl_info info;
+  if (dladdr(address, &info) == 0 || info.dli_sname == nullptr) {
+    snprintf(name, size, "%p", address);
+    return;
+  }
+  int status = 0;
+  char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+  snprintf(name, size, "%s", status == 0 ? demangled : info.dli_sname);
+  free(demangled);
+  char *parameters = strchr(name, '(');
+  if (parameters != nullptr) {
+    *parameters = 0;
+  }
+}
+
+//  Adds a face's profile to the total, matching functions by address.
+static void addProfile(ProfileResult &total, const ProfileResult &face) {
+  unsigned int mapped[PROFILE_FUNCTIONS];
+  for (unsigned int r = 0; r < face.count; r++) {
+    const ProfileFunction &from = face.functions[r];
+    unsigned int t = 0;
+    while (t < total.count && total.functions[t].address != from.address) {
+      t++;
+    }
+    if (t == total.count) {
+      total.functions[total.count++].address = from.address;
+    }
+    mapped[r] = t;
+    ProfileFunction &to = total.functions[t];
+    to.calls += from.calls;
+    to.nanos += from.nanos;
+    to.worstTickCalls = std::max(to.worstTickCalls, from.worstTickCalls);
+    to.deepest = std::max(to.deepest, from.deepest);
+    to.stackBytes = std::max(to.stackBytes, from.stackBytes);
+  }
+  total.ticks += face.ticks;
+  total.overflow = total.overflow || face.overflow;
+  total.stuck = total.stuck || face.stuck;
+  if (face.chainLength > total.chainLength) {
+    total.chainLength = face.chainLength;
+    total.chainStackBytes = face.chainStackBytes;
+    for (unsigned int r = 0; r < face.chainLength; r++) {
+      total.chain[r] = mapped[face.chain[r]];
+    }
+  }
+}
+
+static ProfileResult total;
+
+static bool byNanos(unsigned int a, unsigned int b) {
+  return total.functions[a].nanos > total.functions[b].nanos;
+}
+
+int main(int argc, char **argv) {
+  int onlyFace = -1;
+  unsigned int top = PROFILE_DEFAULT_TOP;
+
+  for (int r = 1; r < argc; r++) {
+    if (strcmp(argv[r], "--ticks") == 0 && r + 1 < argc) {
+      ticks = strtoul(argv[++r], nullptr, 10);
+    } else if (strcmp(argv[r], "--face") == 0 && r + 1 < argc) {
+      onlyFace = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--top") == 0 && r + 1 < argc) {
+      top = strtoul(argv[++r], nullptr, 10);
+    } else {
+      fprintf(stderr, "Usage: %s [--ticks <n>] [--face <n>] [--top <n>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  ProfileResult *face = (ProfileResult *)malloc(sizeof(ProfileResult));
+  int faces = 0;
+  for (int f = 0; f < SIM_FACTORY_FACES; f++) {
+    if (onlyFace >= 0 && f != onlyFace) {
+      continue;
+    }
+    if (!simRunIsolated(runFace, &f, face, sizeof(*face))) {
+      fprintf(stderr, "Simulation of face %d failed\n", f);
+      return 1;
+    }
+    addProfile(total, *face);
+    faces++;
+  }
+  free(face);
+
+  if (faces == 0) {
+    fprintf(stderr, "No face %d\n", onlyFace);
+    return 1;
+  }
+  if (total.overflow) {
+    fprintf(stderr, "More than %d functions or calls deeper than %d, the profile is incomplete\n",
+            PROFILE_FUNCTIONS, PROFILE_DEPTH);
+  }
+  if (total.stuck) {
+    fprintf(stderr, "A menu did not return to normal mode\n");
+  }
+
+  unsigned int order[PROFILE_FUNCTIONS];
+  for (unsigned int r = 0; r < total.count; r++) {
+    order[r] = r;
+  }
+  std::sort(order, order + total.count, byNanos);
+
+  printf("Faces run: %d, %lu ticks each with a face switch every %d ticks, then menus 1 to %d\n",
+         faces, ticks, PROFILE_SWITCH_TICKS, PROFILE_MENUS);
+  printf("%-32s %12s %10s %10s %10s %8s %8s\n",
+         "Function", "calls", "calls/tick", "worst/tick", "host ms", "ns/call", "depth");
+  char name[128];
+  for (unsigned int r = 0; r < total.count && (top == 0 || r < top); r++) {
+    const ProfileFunction &entry = total.functions[order[r]];
+    functionName(entry.address, name, sizeof(name));
+    printf("%-32s %12llu %10.1f %10llu %10.1f %8.0f %8u\n", name, entry.calls,
+           (double)entry.calls / total.ticks, entry.worstTickCalls, entry.nanos / 1e6,
+           (double)entry.nanos / entry.calls, entry.deepest);
+  }
+
+  printf("Deepest call chain, %u calls, %u bytes of host stack:\n", total.chainLength, total.chainStackBytes);
+  for (unsigned int r = 0; r < total.chainLength; r++) {
+    functionName(total.functions[total.chain[r]].address, name, sizeof(name));
+    printf("  %*s%s\n", r * 2, "", name);
+  }
+  return total.overflow || total.stuck ? 1 : 0;
+}
@@ -0,0 +1,612 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Golden-frame check of the ring drawing: runs clock faces through the clock cycle and compares
+// the emulated rings after every tick with the reference renderer in face_reference.cpp.
+//
+// Usage: program [options]
+//   --exhaustive        Check every face that can be set up instead of the factory faces.
+//   --face <n>          Only check this factory face.
+//   --seconds <n>       Ticks per face (default 43200, 86400 with --exhaustive).
+//   --marker-color <n>  Marker color for faces without one (default 4, blue).
+//   --jobs <n>          Worker processes (default one per core).
+//   --shard <i>/<n>     Only check every n-th face starting at i, for splitting a run over
+//                       several machines.
+//   --report <n>        Mismatching ticks printed per failed face (default 3).
+//   --failures <n>      Failed faces printed in detail (default 20).
+//   --progress          Print the number of checked faces while running.
+//   --pic <revision>    PIC firmware revision: full (default), nowrap, basic or silent, to
+//                       check the fallbacks of the ring emitter.
+//   --baud <rate>       Fastest baud rate the PIC keeps up with (default 115200).
+//   --realtime          Let the clock run in virtual time instead of skipping to each second
+//                       edge, so the firmware draws every second ahead of its edge. Slower.
+//   --render            Only check the firmware's renderFace() against the reference, without
+//                       the board, and renderFaceChange() against renderFace() for each tick
+//                       and for a jump to it from a time further back. Several times faster,
+//                       for sweeping every face over a day.
+//   --sweep             Turn on the sweep of the seconds hand in every face and check the
+//                       rings after each step of it as well, and that each second leaves the
+//                       tail lit from its edge on. Implies --realtime.
+//   --transitions       Switch between each face and the next one of the run with the buttons
+//                       every few seconds, at a different point of the second each time, and
+//                       check the rings after each step of the face transition and after it.
+//                       The next face has the sweep of the seconds hand turned on. Implies
+//                       --realtime.
+//
+// The factory check runs each of the factory faces in every marker mode. The exhaustive check
+// covers all 8 colors in each of the 3 styles for the hours, minutes and seconds with each of
+// the 3 marker modes, 41472 faces, spread over the workers through a shared work queue.
+//
+// Each face starts at 23:59:59 on a freshly reset board, so the first tick draws the whole face
+// from scratch, and then steps through the following seconds. Exits with 1 if any LED differs
+// from the reference, a ring command is malformed or the ring link overran or timed out.
+//
+//-------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "sim_hal.h"
+#include "board.h"
+#include "firmware.h"
+#include "face_reference.h"
+
+#define VERIFY_HALF_DAY         43200
+#define VERIFY_DAY              86400
+#define VERIFY_MAX_REPORT       16
+#define VERIFY_MARKER_MODES     4
+
+//  EEPROM address of the first face, as in src/main.cpp.
+#define VERIFY_EEPROM_FACES     10
+#define VERIFY_FACE_LENGTH      10
+
+//  Face settings bits, as in src/main.cpp.
+#define VERIFY_COLORS           8
+#define VERIFY_STYLES           3
+static const uint8_t styles[VERIFY_STYLES] = { 0x10, 0x20, 0x40 };
+static const uint8_t markerModes[VERIFY_MARKER_MODES] = { 0x00, 0x10, 0x20, 0x40 };
+static const char *markerModeNames[VERIFY_MARKER_MODES] = { "none", "every", "quarters", "twelfth" };
+#define VERIFY_SWEEP            0x80
+#define VERIFY_SWEEP_TAIL       0x01
+#define VERIFY_SWEEP_BLIP       0x02
+
+//  Face transitions, as in src/main.cpp: buttons 1 and 3 select the previous and next face, a
+//  transition takes 6 steps, and every step but the last ends with a delay of 5 ms.
+#define VERIFY_PIN_BUTTON1              8
+#define VERIFY_PIN_BUTTON3              10
+#define VERIFY_TRANSITION_STEPS         6
+#define VERIFY_TRANSITION_STEP_DELAY    5
+
+//  Seconds between face switches, and the step of the point in the second they are made at.
+#define VERIFY_TRANSITION_TICKS         7
+#define VERIFY_TRANSITION_OFFSET_MS     379
+
+//  Settings per hand in the exhaustive check, and faces in total with all marker modes but none.
+#define VERIFY_HAND_SETTINGS    (VERIFY_COLORS * VERIFY_STYLES)
+#define VERIFY_EXHAUSTIVE_FACES ((VERIFY_MARKER_MODES - 1) * VERIFY_HAND_SETTINGS * VERIFY_HAND_SETTINGS * \
+                                 VERIFY_HAND_SETTINGS)
+
+//  What the rings should show: a face at a time with a sweep overlay of the seconds hand, 0 for
+//  none. Part way through a face transition the new face only covers the positions up to
+//  sector, and the face shown before with its overlay the rest.
+struct VerifyExpect {
+  uint8_t face[FACE_BYTES];
+  uint8_t hours, minutes, seconds;
+  uint8_t sweep;
+  uint8_t sector;
+  uint8_t fromFace[FACE_BYTES];
+  uint8_t fromSweep;
+};
+
+struct VerifyMismatch {
+  VerifyExpect expect;
+  uint8_t ring, position;
+  uint8_t expected, actual;
+  uint8_t leds;
+};
+
+struct VerifyResult {
+  uint8_t face[FACE_BYTES];
+  uint32_t ticks;
+  uint32_t failedTicks;
+  uint32_t malformed;
+  uint32_t linkErrors;
+  uint32_t changeFailures;
+  uint32_t transitions;
+  uint32_t transitionFailures;
+  uint32_t tailFailures;
+  uint8_t reported;
+  VerifyMismatch mismatches[VERIFY_MAX_REPORT];
+};
+
+static SimBoard board;
+static uint32_t runSeconds = 0;
+static int reportLimit = 3;
+static bool exhaustive = false;
+static int onlyFace = -1;
+static uint8_t markerColor = 0x04;
+static int shardIndex = 0, shardCount = 1;
+static uint8_t picFeatures = PIC_FEATURES_ALL;
+static unsigned long picBaudLimit = 115200;
+static bool realTime = false;
+static bool renderOnly = false;
+static bool sweep = false;
+static bool transitions = false;
+
+//  Faces of this run, in the order of the work queue.
+static int faceCount = 0;
+static uint8_t (*faces)[FACE_BYTES] = nullptr;
+
+static const char ringNames[PIC_RING_COUNT] = { 'H', 'M', 'S' };
+
+//  Builds the face for a job number of the whole check, before sharding.
+static void makeFace(int job, uint8_t face[FACE_BYTES]) {
+  if (exhaustive) {
+    for (int hand = FACE_SECONDS; hand >= FACE_HOURS; hand--) {
+      int setting = job % VERIFY_HAND_SETTINGS;
+      job /= VERIFY_HAND_SETTINGS;
+      face[hand] = styles[setting / VERIFY_COLORS] | (setting % VERIFY_COLORS);
+    }
+    face[FACE_MARKERS] = markerModes[1 + job] | markerColor;
+    if (sweep) {
+      face[FACE_SECONDS] |= VERIFY_SWEEP;
+    }
+    return;
+  }
+
+  int factory = onlyFace >= 0 ? onlyFace : job / VERIFY_MARKER_MODES;
+  memcpy(face, simEeprom() + VERIFY_EEPROM_FACES + factory * VERIFY_FACE_LENGTH, FACE_BYTES);
+  if ((face[FACE_MARKERS] & 0x0f) == 0) {
+    face[FACE_MARKERS] = markerColor;
+  }
+  face[FACE_MARKERS] = (face[FACE_MARKERS] & 0x0f) | markerModes[job % VERIFY_MARKER_MODES];
+  if (sweep) {
+    face[FACE_SECONDS] |= VERIFY_SWEEP;
+  }
+}
+
+//  Reference for what the rings should show.
+static void expectedLeds(const VerifyExpect &expect, uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]) {
+  referenceRenderFace(expect.face, expect.hours, expect.minutes, expect.seconds, leds);
+  referenceRenderSweep(expect.face, expect.seconds, expect.sweep & VERIFY_SWEEP_TAIL, expect.sweep & VERIFY_SWEEP_BLIP, leds);
+  if (expect.sector < PIC_RING_POSITIONS) {
+    uint8_t from[PIC_RING_COUNT][PIC_RING_POSITIONS];
+    referenceRenderFace(expect.fromFace, expect.hours, expect.minutes, expect.seconds, from);
+    referenceRenderSweep(expect.fromFace, expect.seconds, expect.fromSweep & VERIFY_SWEEP_TAIL,
+                         expect.fromSweep & VERIFY_SWEEP_BLIP, from);
+    for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+      memcpy(leds[ring] + expect.sector, from[ring] + expect.sector, PIC_RING_POSITIONS - expect.sector);
+    }
+  }
+}
+
+//  A face at a time with a sweep overlay, outside of a face transition.
+static VerifyExpect expectFace(const uint8_t face[FACE_BYTES], uint8_t hours, uint8_t minutes, uint8_t seconds,
+                               uint8_t sweepOverlay) {
+  VerifyExpect expect;
+  memcpy(expect.face, face, FACE_BYTES);
+  expect.hours = hours;
+  expect.minutes = minutes;
+  expect.seconds = seconds;
+  expect.sweep = sweepOverlay;
+  expect.sector = PIC_RING_POSITIONS;
+  memcpy(expect.fromFace, face, FACE_BYTES);
+  expect.fromSweep = 0;
+  return expect;
+}
+
+//  Compares rings, indexed like PicRingEmulator, with the reference, returns true if they match.
+static bool checkLeds(VerifyResult &result, const VerifyExpect &expect,
+                      const uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS]) {
+  uint8_t expected[PIC_RING_COUNT][PIC_RING_POSITIONS];
+  expectedLeds(expect, expected);
+
+  VerifyMismatch first;
+  uint8_t different = 0;
+  for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+    for (uint8_t position = 0; position < PIC_RING_POSITIONS; position++) {
+      uint8_t actual = leds[ring][position];
+      if (actual != expected[ring][position]) {
+        if (different == 0) {
+          first.ring = ring;
+          first.position = position;
+          first.expected = expected[ring][position];
+          first.actual = actual;
+        }
+        different++;
+      }
+    }
+  }
+
+  result.ticks++;
+  if (different == 0) {
+    return true;
+  }
+
+  result.failedTicks++;
+  if (result.reported < reportLimit) {
+    first.expect = expect;
+    first.leds = different;
+    result.mismatches[result.reported++] = first;
+  }
+  return false;
+}
+
+//  Compares the emulated rings with the reference.
+static bool checkBoard(VerifyResult &result, const VerifyExpect &expect) {
+  uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS];
+  for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+    for (uint8_t position = 0; position < PIC_RING_POSITIONS; position++) {
+      leds[ring][position] = board.pic.led(ring, position);
+    }
+  }
+  return checkLeds(result, expect, leds);
+}
+
+//  The faces in slot 0 and 1 of a transitions run, see runFace().
+static uint8_t slotFaces[2][FACE_BYTES];
+
+//  Face the firmware has selected.
+static const uint8_t *selectedFace(const VerifyResult &result) {
+  return transitions ? slotFaces[clockFace & 1] : result.face;
+}
+
+//  Compares the emulated rings with the reference, and the sweep overlay the firmware drew.
+static bool checkTick(VerifyResult &result) {
+  return checkBoard(result, expectFace(selectedFace(result), hours, minutes, seconds, sweepShown));
+}
+
+//  Face transition under way: the result it is checked into, the face switched from with the
+//  overlay it showed, and the steps seen so far.
+static VerifyResult *transitionResult = nullptr;
+static uint8_t transitionFrom[FACE_BYTES];
+static uint8_t transitionFromSweep = 0;
+static int transitionSteps = 0;
+static bool transitionChecking = false;
+
+//  Delay hook while a face switch runs through loop(). The button is let go at the first step,
+//  and the rings are checked after each step and at the first other delay after the steps, which
+//  is the wait for the buttons to be released.
+static void transitionDelay(unsigned long ms) {
+  if (transitionResult == nullptr || transitionChecking) {
+    return;
+  }
+  if (ms != VERIFY_TRANSITION_STEP_DELAY && transitionSteps == 0) {
+    return;
+  }
+
+  transitionChecking = true;
+  simSetPin(VERIFY_PIN_BUTTON1, HIGH);
+  simSetPin(VERIFY_PIN_BUTTON3, HIGH);
+  ringFrameFlushAndWait();
+  simAdvanceTo(simUartIdleNanos());
+
+  VerifyExpect expect = expectFace(selectedFace(*transitionResult), hours, minutes, seconds, 0);
+  if (ms == VERIFY_TRANSITION_STEP_DELAY) {
+    if (transitionSteps == 0) {
+      transitionFromSweep = sweepShown;
+    }
+    transitionSteps++;
+    expect.sector = transitionSteps * PIC_RING_POSITIONS / VERIFY_TRANSITION_STEPS;
+    memcpy(expect.fromFace, transitionFrom, FACE_BYTES);
+    expect.fromSweep = transitionFromSweep;
+    checkBoard(*transitionResult, expect);
+  } else {
+    if (transitionSteps != VERIFY_TRANSITION_STEPS - 1) {
+      transitionResult->transitionFailures++;
+    }
+    checkBoard(*transitionResult, expect);
+    transitionResult->transitions++;
+    transitionResult = nullptr;
+  }
+  transitionChecking = false;
+}
+
+//  Switches to the other face of the run with the buttons, button 3 from slot 0 to 1 and
+//  button 1 back, and runs loop() through the transition.
+static void switchFace(VerifyResult &result) {
+  memcpy(transitionFrom, selectedFace(result), FACE_BYTES);
+  transitionSteps = 0;
+  transitionResult = &result;
+
+  simSetPin(clockFace == 0 ? VERIFY_PIN_BUTTON3 : VERIFY_PIN_BUTTON1, LOW);
+  loop();
+
+  //  A switch that did not get to the end of the transition
+  if (transitionResult != nullptr) {
+    result.transitionFailures++;
+    transitionResult = nullptr;
+  }
+  simSetPin(VERIFY_PIN_BUTTON1, HIGH);
+  simSetPin(VERIFY_PIN_BUTTON3, HIGH);
+}
+
+//  Steps renderFace() through the ticks from 23:59:59 on and compares each frame with the
+//  reference. The frame's rings run seconds, minutes, hours, the other way round to the PIC.
+//  A frame carried along from tick to tick by renderFaceChange(), and one it jumps to the tick
+//  from a time up to a day back, must come out the same as the frame renderFace() draws.
+static void renderFaceTicks(VerifyResult &result) {
+  byte ticked[PIC_RING_COUNT][3][8];
+  uint32_t second = VERIFY_DAY - 1;
+  for (uint32_t tick = 0; tick <= runSeconds; tick++, second = (second + 1) % VERIFY_DAY) {
+    uint8_t h = second / 3600, m = second / 60 % 60, s = second % 60;
+    byte frame[PIC_RING_COUNT][3][8];
+    renderFace(result.face, h, m, s, frame);
+
+    uint32_t from = (second + VERIFY_DAY - tick * 7919 % VERIFY_DAY) % VERIFY_DAY;
+    byte jumped[PIC_RING_COUNT][3][8];
+    renderFace(result.face, from / 3600, from / 60 % 60, from % 60, jumped);
+    renderFaceChange(result.face, from / 3600, from / 60 % 60, from % 60, h, m, s, jumped);
+    if (tick == 0) {
+      memcpy(ticked, frame, sizeof(ticked));
+    } else {
+      uint32_t previous = (second + VERIFY_DAY - 1) % VERIFY_DAY;
+      renderFaceChange(result.face, previous / 3600, previous / 60 % 60, previous % 60, h, m, s, ticked);
+    }
+    if (memcmp(ticked, frame, sizeof(frame)) != 0 || memcmp(jumped, frame, sizeof(frame)) != 0) {
+      result.changeFailures++;
+    }
+
+    uint8_t leds[PIC_RING_COUNT][PIC_RING_POSITIONS];
+    for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+      for (uint8_t position = 0; position < PIC_RING_POSITIONS; position++) {
+        uint8_t color = 0;
+        for (uint8_t plane = 0; plane < 3; plane++) {
+          color |= ((frame[PIC_RING_COUNT - 1 - ring][plane][position >> 3] >> (position & 7)) & 1) << plane;
+        }
+        leds[ring][position] = color;
+      }
+    }
+    checkLeds(result, expectFace(result.face, h, m, s, 0), leds);
+  }
+}
+
+static void runFace(int job, void *output) {
+  VerifyResult &result = *(VerifyResult *)output;
+
+  if (renderOnly) {
+    memcpy(result.face, faces[job], FACE_BYTES);
+    renderFaceTicks(result);
+    return;
+  }
+
+  board.powerOn();
+  board.loadFactorySettings(0);
+  board.pic.setFeatures(picFeatures);
+  board.pic.setBaudLimit(picBaudLimit);
+  board.pic.setRecording(false);
+  board.display.setRecording(false);
+
+  //  Load the face into slot 0, and the face to switch to into slot 1.
+  memcpy(result.face, faces[job], FACE_BYTES);
+  memcpy(simEeprom() + VERIFY_EEPROM_FACES, faces[job], FACE_BYTES);
+  if (transitions) {
+    memcpy(slotFaces[0], faces[job], FACE_BYTES);
+    memcpy(slotFaces[1], faces[(job + 1) % faceCount], FACE_BYTES);
+    slotFaces[1][FACE_SECONDS] |= VERIFY_SWEEP;
+    memcpy(simEeprom() + VERIFY_EEPROM_FACES + VERIFY_FACE_LENGTH, slotFaces[1], FACE_BYTES);
+    simSetDelayHook(transitionDelay);
+  }
+
+  setup();
+  board.rtc.setDateTime(19, 12, 31, 3, 23, 59, 59);
+  board.rtc.setSkipToEdge(!realTime);
+  unsigned long switchMillis = 0;
+
+  //  Initial draw at 23:59:59, then one check per tick.
+  uint64_t startEdges = board.rtc.edges();
+  //  Rates the PIC does not keep up with are lost while the baud rate is negotiated in setup().
+  uint64_t startLinkErrors = ringLinkTimeouts + ringLinkErrors + board.pic.stats().overruns +
+                             board.pic.stats().misclocked;
+  do {
+    uint64_t edges = board.rtc.edges();
+    do {
+      byte step = sweepStep;
+      byte second = seconds;
+      if (switchMillis != 0 && millis() >= switchMillis) {
+        switchMillis = 0;
+        switchFace(result);
+        continue;
+      }
+      loop();
+      //  A sweeping face leaves the tail lit from the edge on, rather than a step after it.
+      if (mode == 0 && seconds != second && (secondsColor & VERIFY_SWEEP) && sweepShown != VERIFY_SWEEP_TAIL) {
+        result.tailFailures++;
+      }
+      if (sweep && sweepStep != step && board.rtc.edges() == edges) {
+        ringFrameFlushAndWait();
+        simAdvanceTo(simUartIdleNanos());
+        checkTick(result);
+      }
+    } while (realTime && board.rtc.edges() == edges);
+    ringFrameFlushAndWait();
+    simAdvanceTo(simUartIdleNanos());
+    checkTick(result);
+
+    uint64_t tick = board.rtc.edges() - startEdges;
+    if (transitions && tick % VERIFY_TRANSITION_TICKS == 0) {
+      switchMillis = millis() + 1 + tick / VERIFY_TRANSITION_TICKS * VERIFY_TRANSITION_OFFSET_MS % 1000;
+    }
+  } while (board.rtc.edges() - startEdges < runSeconds);
+
+  board.pic.finish();
+  result.malformed = board.pic.stats().malformed;
+  result.linkErrors = (uint32_t)(ringLinkTimeouts + ringLinkErrors + board.pic.stats().overruns +
+                                 board.pic.stats().misclocked - startLinkErrors);
+}
+
+static void printRing(const uint8_t *leds) {
+  for (uint8_t position = 0; position < PIC_RING_POSITIONS; position++) {
+    putchar(picColorChar(leds[position]));
+  }
+}
+
+static void printFailure(const VerifyResult &result) {
+  for (uint8_t r = 0; r < result.reported; r++) {
+    const VerifyMismatch &m = result.mismatches[r];
+    printf("    %02u:%02u:%02u  %u LEDs differ, first %c%02u is %c, expected %c\n",
+           m.expect.hours, m.expect.minutes, m.expect.seconds, m.leds, ringNames[m.ring], m.position,
+           picColorChar(m.actual), picColorChar(m.expected));
+  }
+  if (result.reported > 0) {
+    uint8_t expected[PIC_RING_COUNT][PIC_RING_POSITIONS];
+    const VerifyExpect &e = result.mismatches[0].expect;
+    expectedLeds(e, expected);
+    printf("    reference of face %02X %02X %02X %02X at %02u:%02u:%02u%s%s", e.face[0], e.face[1], e.face[2], e.face[3],
+           e.hours, e.minutes, e.seconds,
+           e.sweep & VERIFY_SWEEP_TAIL ? " with tail" : "", e.sweep & VERIFY_SWEEP_BLIP ? " with blip" : "");
+    if (e.sector < PIC_RING_POSITIONS) {
+      printf(", from position %u still face %02X %02X %02X %02X%s%s", e.sector,
+             e.fromFace[0], e.fromFace[1], e.fromFace[2], e.fromFace[3],
+             e.fromSweep & VERIFY_SWEEP_TAIL ? " with tail" : "", e.fromSweep & VERIFY_SWEEP_BLIP ? " with blip" : "");
+    }
+    printf("\n");
+    for (uint8_t ring = 0; ring < PIC_RING_COUNT; ring++) {
+      printf("      %c ", ringNames[ring]);
+      printRing(expected[ring]);
+      printf("\n");
+    }
+  }
+}
+
+static const char *markerModeName(uint8_t markers) {
+  for (int mode = VERIFY_MARKER_MODES - 1; mode > 0; mode--) {
+    if (markers & markerModes[mode]) {
+      return markerModeNames[mode];
+    }
+  }
+  return markerModeNames[0];
+}
+
+int main(int argc, char **argv) {
+  int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int failureLimit = 20;
+  bool progress = false;
+
+  for (int r = 1; r < argc; r++) {
+    if (strcmp(argv[r], "--exhaustive") == 0) {
+      exhaustive = true;
+    } else if (strcmp(argv[r], "--face") == 0 && r + 1 < argc) {
+      onlyFace = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--seconds") == 0 && r + 1 < argc) {
+      runSeconds = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--marker-color") == 0 && r + 1 < argc) {
+      markerColor = atoi(argv[++r]) & 0x07;
+    } else if (strcmp(argv[r], "--jobs") == 0 && r + 1 < argc) {
+      jobs = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--shard") == 0 && r + 1 < argc &&
+               sscanf(argv[r + 1], "%d/%d", &shardIndex, &shardCount) == 2 &&
+               shardCount > 0 && shardIndex >= 0 && shardIndex < shardCount) {
+      r++;
+    } else if (strcmp(argv[r], "--report") == 0 && r + 1 < argc) {
+      reportLimit = atoi(argv[++r]);
+      if (reportLimit > VERIFY_MAX_REPORT) {
+        reportLimit = VERIFY_MAX_REPORT;
+      }
+    } else if (strcmp(argv[r], "--failures") == 0 && r + 1 < argc) {
+      failureLimit = atoi(argv[++r]);
+    } else if (strcmp(argv[r], "--progress") == 0) {
+      progress = true;
+    } else if (strcmp(argv[r], "--pic") == 0 && r + 1 < argc && PicRingEmulator::parseFeatures(argv[r + 1], picFeatures)) {
+      r++;
+    } else if (strcmp(argv[r], "--baud") == 0 && r + 1 < argc && PicRingEmulator::parseBaud(argv[r + 1], picBaudLimit)) {
+      r++;
+    } else if (strcmp(argv[r], "--realtime") == 0) {
+      realTime = true;
+    } else if (strcmp(argv[r], "--render") == 0) {
+      renderOnly = true;
+    } else if (strcmp(argv[r], "--sweep") == 0) {
+      sweep = true;
+      realTime = true;
+    } else if (strcmp(argv[r], "--transitions") == 0) {
+      transitions = true;
+      realTime = true;
+    } else {
+      fprintf(stderr, "Usage: %s [--exhaustive] [--face <n>] [--seconds <n>] [--marker-color <n>] [--jobs <n>]\n"
+                      "       [--shard <i>/<n>] [--report <n>] [--failures <n>] [--progress] [--pic <revision>]\n"
+                      "       [--baud <rate>] [--realtime] [--render] [--sweep] [--transitions]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (runSeconds == 0) {
+    runSeconds = exhaustive ? VERIFY_DAY : VERIFY_HALF_DAY;
+  }
+  if (jobs < 1) {
+    jobs = 1;
+  }
+
+  //  The factory faces are read back from the EEPROM image.
+  board.powerOn();
+  board.loadFactorySettings(0);
+
+  int total = exhaustive ? VERIFY_EXHAUSTIVE_FACES :
+              (onlyFace >= 0 ? 1 : SIM_FACTORY_FACES) * VERIFY_MARKER_MODES;
+  faces = new uint8_t[total][FACE_BYTES];
+  for (int job = shardIndex; job < total; job += shardCount) {
+    makeFace(job, faces[faceCount++]);
+  }
+
+  VerifyResult *results = new VerifyResult[faceCount];
+  int crashed = simRunQueue(faceCount, jobs, runFace, results, sizeof(VerifyResult), progress);
+
+  int failed = 0, printed = 0;
+  for (int r = 0; r < faceCount; r++) {
+    const VerifyResult &result = results[r];
+    bool ran = result.ticks > 0;
+    bool passed = ran && result.failedTicks == 0 && result.malformed == 0 && result.linkErrors == 0 &&
+                  result.changeFailures == 0 && result.transitionFailures == 0 &&
+                  result.tailFailures == 0 &&
+                  (!transitions || renderOnly || result.transitions > 0);
+    if (!passed) {
+      failed++;
+    }
+    if (exhaustive && (passed || printed >= failureLimit)) {
+      continue;
+    }
+
+    printf("Face %02X %02X %02X %02X  markers %-8s  %6u ticks  %s",
+           faces[r][0], faces[r][1], faces[r][2], faces[r][3],
+           markerModeName(faces[r][FACE_MARKERS]), result.ticks, passed ? "ok" : "FAILED");
+    if (!ran) {
+      printf("  simulation did not finish");
+    }
+    if (result.failedTicks > 0) {
+      printf("  %u ticks differ", result.failedTicks);
+    }
+    if (result.malformed > 0) {
+      printf("  %u malformed commands", result.malformed);
+    }
+    if (result.linkErrors > 0) {
+      printf("  %u link errors", result.linkErrors);
+    }
+    if (result.changeFailures > 0) {
+      printf("  %u ticks drawn differently by renderFaceChange()", result.changeFailures);
+    }
+    if (transitions && !renderOnly) {
+      printf("  %u transitions", result.transitions);
+    }
+    if (result.transitionFailures > 0) {
+      printf("  %u transitions without their %u steps", result.transitionFailures, VERIFY_TRANSITION_STEPS);
+    }
+    if (result.tailFailures > 0) {
+      printf("  %u seconds drawn without the sweep tail", result.tailFailures);
+    }
+    printf("\n");
+    if (!passed) {
+      printFailure(result);
+      printed++;
+    }
+  }
+
+  printf("Shard %d/%d: %d of %d faces passed", shardIndex, shardCount, faceCount - failed, faceCount);
+  if (crashed > 0) {
+    printf(", %d simulations did not finish", crashed);
+  }
+  printf("\n");
+
+  delete[] results;
+  delete[] faces;
+  return failed == 0 ? 0 : 1;
+}
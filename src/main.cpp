@@ -67,17 +67,23 @@
 //  0xF3, [hours,min,sec], [number of postions to move back], [unused], 0x03
 //        4, 2, 1 => 1-7
 //
-//  *** Meter mode ***    TODO IS REALLY 6 BYTES ???
+//  *** Meter mode, fill start to end with one color (6 bytes) ***
 //  0xF4, [hours,min,sec], [position start number], [position end number], [color], 0x03 
 //        4, 2, 1 => 1-7
 //
-//  *** Turn off all LEDs in selected circle ***    TODO IS REALLY 6 BYTES ???
-//  0xF5, [hours,min,sec], [unused], [unused], [unused], 0x03
+//  *** Turn off all LEDs in selected circle ***
+//  0xF5, [hours,min,sec], [unused], [unused], 0x03
 //        4, 2, 1 => 1-7
 //
 //  *** Turn off all LEDs in all circles ***
 //  0xF6, [unused], [unused], [unused], 0x03
 //
+//  *** Change baud rate (proposed, needs a PIC firmware that has it) ***
+//  0xF7, [unused], [rate], [unused], 0x03
+//                  0-4 => 9600, 19200, 38400, 57600, 115200
+//  The PIC echoes 0xF7 at the old rate and then switches, and goes back to the old rate
+//  unless a good frame follows within 100 ms.
+//
 //-------------------------------------------------------------------------------------------------
 
 #include <Arduino.h>
@@ -91,6 +97,10 @@
 //  Define delays (in milliseconds)
 #define ANIMATION_SHORT_DELAY         10
 #define ANIMATION_KEY_DELAY           50
+#define TRANSITION_STEP_DELAY         5
+#define RING_PROBE_TIMEOUT            20
+#define RING_ECHO_TIMEOUT             50
+#define RING_BAUD_TRIAL_TIMEOUT       100
 #define BUTTON_DEBOUNCE_SHORT_DELAY   100
 #define BUTTON_PAUSE_SHORT_DELAY      20
 #define BUTTON_PAUSE_LONG_DELAY       450
@@ -132,11 +142,20 @@
 #define EEPROM_CLOCK_FACE_NUMBER    0
 #define EEPROM_DATE_TIME_AND_COLON  1
 #define EEPROM_ALTERNATE_COUNTER    2
+#define EEPROM_RING_COMMANDS        3
+#define EEPROM_RING_BAUD            4
 #define EEPROM_CLOCK_FACE_SETTINGS  10
 
 //  Define Eeprom memory size for each clock face
 #define DEFAULT_CLOCK_FACE_LENGTH 10
 
+//  Settings bytes of a face, in the order they are stored in Eeprom
+#define FACE_MARKERS  0
+#define FACE_HOURS    1
+#define FACE_MINUTES  2
+#define FACE_SECONDS  3
+#define FACE_BYTES    4
+
 //  Define number of factory clock faces
 #define DEFAULT_FACTORY_CLOCK_FACES 10
 
@@ -154,6 +173,10 @@
 #define COLOR_BIT_DOT     5
 #define COLOR_BIT_TRACE   6
 
+//  Only in the seconds byte: the seconds hand sweeps towards the next second, see drawSweepStep()
+#define COLOR_SWEEP       0x80
+#define COLOR_BIT_SWEEP   7
+
 //  Define PIC commands
 #define RING_CMD_UNUSED       0x00
 #define RING_CMD_ON_OFF_LEDS  0xF1
@@ -162,7 +185,23 @@
 #define RING_CMD_METER_LEDS   0xF4
 #define RING_CMD_OFF_LEDS     0xF5
 #define RING_CMD_OFF_ALL_LEDS 0xF6
+#define RING_CMD_SET_BAUD     0xF7
 #define RING_CMD_END          0x03
+#define RING_SEQUENCE_END     0x00
+
+//  Define optional PIC commands found by the probe at start up
+#define RING_SUPPORTS_NONE    0x00
+#define RING_SUPPORTS_METER   0x01
+#define RING_SUPPORTS_MOVE    0x02
+#define RING_SUPPORTS_ECHO    0x04
+#define RING_SUPPORTS_BAUD    0x08
+#define RING_SUPPORTS_WRAP    0x10
+#define RING_SUPPORTS_UNKNOWN 0xff
+
+//  Define ring link baud rates, by their index in the set baud command
+#define RING_BAUD_DEFAULT     0
+#define RING_BAUD_FASTEST     4
+#define RING_BAUD_UNKNOWN     0xff
 
 //  Define LED rings commands
 #define RING_NONE                   0x00
@@ -210,6 +249,14 @@
 #define PIN_BUTTON2   9
 #define PIN_BUTTON3   10
 
+//  Optional tick-to-display latency probe, e.g. build_flags = -D LATENCY_PROBE_PIN=13
+//  Enables the 1 Hz square wave on the DS1307 SQW/OUT pin and holds the probe pin HIGH from
+//  the RTC read that sees a new second until the last ring and segment byte has been sent.
+//  With a logic analyser on both pins, SQW/OUT to probe rising is the detect latency and
+//  SQW/OUT to probe falling is the full tick-to-display latency.
+#define DS1307_REG_CONTROL    0x07
+#define DS1307_SQW_1HZ        0x10
+
 //  Define modes
 #define MODE_NORMAL             0
 #define MODE_SET_STYLING        1
@@ -225,8 +272,6 @@ byte clockFace = 0;
 
 //  Date and Time variables
 byte hours, minutes, seconds, years, months, dayOfMonth, dayOfWeek;
-byte hoursHand = 0;
-byte previousHoursHand = 0;
 byte previousHours = 0;
 byte previousMinutes = 0;
 byte previousSeconds = 0;
@@ -234,9 +279,30 @@ byte previousYears = 0;
 byte previousMonths = 0;
 byte previousDayOfMonth = 0;
 
-// Clock display variables
-byte markers = RING_NONE;
-byte loopMarker = 0;
+//  Time of the next second once drawNextClockFace() has tried it, and if its frames are ready
+byte nextHours = 0;
+byte nextMinutes = 0;
+byte nextSeconds = 0;
+bool nextDrawn = false;
+bool nextReady = false;
+
+//  Face the back buffer holds at the previous time, unless something else was drawn since
+byte drawnFace[FACE_BYTES];
+bool drawnFaceValid = false;
+
+//  Sweep of the seconds hand: millis() at the second edge, the steps of this second drawn so
+//  far, and the overlay the back buffer holds
+#define SWEEP_NONE          0x00
+#define SWEEP_TAIL          0x01
+#define SWEEP_BLIP          0x02
+#define SWEEP_STEPS         4
+#define SWEEP_STEP_MILLIS   250
+unsigned long sweepMillis = 0;
+byte sweepStep = SWEEP_STEPS;
+byte sweepShown = SWEEP_NONE;
+
+//  Overlay of the second shown while the back buffer holds the next one, see drawNextClockFace()
+byte nextSweep = SWEEP_NONE;
 
 #define DISP_CHAR_BLANK     ' '
 #define DISP_CHAR_SELECTED  ' '
@@ -291,7 +357,7 @@ byte secondsColor = COLOR_GREEN;
 //  bit 5 = dot mode active
 //  bit 6 = trace mode active
 //
-const byte DEFAULT_FACTORY_COLORS[DEFAULT_FACTORY_CLOCK_FACES][4] =
+const byte DEFAULT_FACTORY_COLORS[DEFAULT_FACTORY_CLOCK_FACES][FACE_BYTES] =
 {
   // Hands examples
   {COLOR_BLUE|MARKER_HOUR_EVERY, COLOR_CYAN|COLOR_HANDS, COLOR_GREEN|COLOR_HANDS, COLOR_RED|COLOR_HANDS},
@@ -552,38 +618,409 @@ byte translateCharTo7SegDigit(char value, boolean hideZeros) {
 
 //  ====================================================================================
 
-//  Write circle LED data
+//  Ring framebuffer
 //
-void ledWrite(byte ring, byte number, byte color) {
-  Serial.write(RING_CMD_ON_OFF_LEDS);
-  Serial.write(ring);
-  Serial.write(number); //  LED to light (0-59)
-  Serial.write(color);
-  Serial.write(RING_CMD_END);
+//  Shadow copies of the 3x60 ring LEDs at 3 bits per LED, kept as three bit planes of 60 bits
+//  for each ring. The clock face is drawn into the back buffer with ringFrameSet() and
+//  ringFrameClear(), and ringFrameFlush() sends only the LEDs that differ from the front
+//  buffer, which follows what the PIC shows. Commands written directly with ledWrite() and
+//  ledWriteAllInRingOff() go to both buffers.
+//
+//  Rings are indexed by their bit in the ring commands: seconds 0, minutes 1, hours 2.
+
+#define RING_COUNT          3
+#define RING_POSITIONS      60
+#define RING_FRAME_PLANES   3
+#define RING_FRAME_BYTES    8
+#define RING_FRAME_SIZE     (RING_COUNT * RING_FRAME_PLANES * RING_FRAME_BYTES)
 
-  Serial.read();
+byte ringFrameBack[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES];
+byte ringFrameFront[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES];
+
+//  Optional commands the PIC takes, see ringProbeCommands()
+byte ringCommands = RING_SUPPORTS_NONE;
+
+//  Baud rate of the ring link, see ringNegotiateBaud()
+byte ringBaud = RING_BAUD_DEFAULT;
+
+unsigned long ringBaudRate(byte index) {
+  switch (index) {
+    case 1:   return 19200;
+    case 2:   return 38400;
+    case 3:   return 57600;
+    case 4:   return 115200;
+    default:  return 9600;
+  }
 }
 
-void ledWriteMeter(byte ring, byte startPos, byte endPos, byte color) {
-  // TODO - Does not seem to work with current PIC version?
-  Serial.write(RING_CMD_METER_LEDS);
-  Serial.write(ring);
-  Serial.write(startPos); //  LED to start light (0-59)
-  Serial.write(endPos);   //  LED to end light (0-59)
-  Serial.write(color);
-//  Serial.write(RING_CMD_END);
+void ringBaudSet(byte index) {
+  Serial.flush();
+  Serial.begin(ringBaudRate(index));
+  ringBaud = index;
+}
 
-  Serial.read();
+byte ringFrameGet(byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES], byte ring, byte position) {
+  byte color = COLOR_BLANK;
+  for (byte plane = 0; plane < RING_FRAME_PLANES; plane++) {
+    if (bitRead(frame[ring][plane][position >> 3], position & 0x07) == 1) {
+      bitSet(color, plane);
+    }
+  }
+  return color;
 }
 
-void ledWriteAllInRingOff(byte ring) {
-  Serial.write(RING_CMD_OFF_LEDS);
-  Serial.write(ring);
-  Serial.write(RING_CMD_UNUSED);
-  Serial.write(RING_CMD_UNUSED);
-  Serial.write(RING_CMD_END);
+//  Sets a LED in all rings of the ring command bits.
+void ringFramePut(byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES], byte rings, byte position, byte color) {
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    if (bitRead(rings, ring) == 1) {
+      for (byte plane = 0; plane < RING_FRAME_PLANES; plane++) {
+        bitWrite(frame[ring][plane][position >> 3], position & 0x07, bitRead(color, plane));
+      }
+    }
+  }
+}
+
+void ringFrameErase(byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES], byte rings) {
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    if (bitRead(rings, ring) == 1) {
+      memset(frame[ring], 0, sizeof(frame[ring]));
+    }
+  }
+}
+
+//  Moves the LEDs of a ring clockwise by shift positions, as the PIC does on a move command.
+void ringFrameRotate(byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES], byte ring, byte shift) {
+  byte moved = 0;
+  byte rings = RING_NONE;
+  bitSet(rings, ring);
+
+  //  Each cycle carries one color along the positions shift apart until it gets back to
+  //  where it started.
+  for (byte start = 0; moved < RING_POSITIONS; start++) {
+    byte position = start;
+    byte color = ringFrameGet(frame, ring, start);
+    do {
+      position = (position + shift) % RING_POSITIONS;
+      byte next = ringFrameGet(frame, ring, position);
+      ringFramePut(frame, rings, position, color);
+      color = next;
+      moved++;
+    } while (position != start);
+  }
+}
+
+void ringFrameSet(byte rings, byte position, byte color) {
+  drawnFaceValid = false;
+  ringFramePut(ringFrameBack, rings, position, color);
+}
 
-  Serial.read();
+void ringFrameClear(byte rings) {
+  drawnFaceValid = false;
+  ringFrameErase(ringFrameBack, rings);
+}
+
+//  ====================================================================================
+
+//  Ring command queue
+//
+//  Whole frames wait at high priority, or low for the scrubber, and move into the serial TX buffer
+//  as it has room. A PIC that echoes gets at most RING_CREDITS frames ahead of its echoes.
+
+#define RING_QUEUE_HIGH       0
+#define RING_QUEUE_LOW        1
+#define RING_QUEUE_PRIORITIES 2
+#define RING_QUEUE_BYTES      32
+#define RING_FRAME_MAX        6
+#define RING_CREDITS          2
+#define RING_ECHO_RETRIES     3
+#define RING_SCRUB_POSITIONS  4
+
+byte ringQueue[RING_QUEUE_PRIORITIES][RING_QUEUE_BYTES];
+byte ringQueueHead[RING_QUEUE_PRIORITIES];
+byte ringQueueCount[RING_QUEUE_PRIORITIES];
+
+//  Queue and bytes left of the frame being moved to the TX buffer
+byte ringQueueSending = RING_QUEUE_HIGH;
+byte ringQueueFrameLeft = 0;
+bool ringQueueHeld = false;
+
+//  Command bytes of the frames in flight, oldest first, and when the last echo came
+byte ringEchoExpected[RING_CREDITS];
+byte ringEchoPending = 0;
+unsigned long ringEchoMillis = 0;
+byte ringEchoMisses = 0;
+bool ringFrameRedraw = false;
+
+//  Link error counters: echo timeouts and echoes that were not expected
+unsigned int ringLinkTimeouts = 0;
+unsigned int ringLinkErrors = 0;
+
+//  Next position to scrub, positions left this second and rings left at the position
+byte ringScrubPosition = 0;
+byte ringScrubLeft = 0;
+byte ringScrubRings = RING_NONE;
+
+byte ringCommandLength(byte command) {
+  return command == RING_CMD_METER_LEDS ? 6 : 5;
+}
+
+byte ringQueueFree(byte priority) {
+  return RING_QUEUE_BYTES - ringQueueCount[priority];
+}
+
+//  True when nothing waits to be sent now, held frames wait for their edge.
+bool ringQueueIdle() {
+  return (ringQueueCount[RING_QUEUE_HIGH] == 0 || ringQueueHeld) && ringQueueCount[RING_QUEUE_LOW] == 0;
+}
+
+//  Takes the echoes the PIC sent back and gives up on the frames in flight after the timeout.
+void ringEchoReceive() {
+  if ((ringCommands & RING_SUPPORTS_ECHO) == 0) {
+    return;
+  }
+
+  while (Serial.available() > 0) {
+    byte echo = Serial.read();
+    if (ringEchoPending > 0 && echo == ringEchoExpected[0]) {
+      ringEchoPending--;
+      for (byte r = 0; r < ringEchoPending; r++) {
+        ringEchoExpected[r] = ringEchoExpected[r + 1];
+      }
+      ringEchoMillis = millis();
+      ringEchoMisses = 0;
+    } else {
+      ringLinkErrors++;
+    }
+  }
+
+  if (ringEchoPending > 0 && millis() - ringEchoMillis > RING_ECHO_TIMEOUT) {
+    ringLinkTimeouts++;
+    ringEchoPending = 0;
+    ringFrameRedraw = true;
+
+    ringEchoMisses++;
+    if (ringEchoMisses >= RING_ECHO_RETRIES) {
+      //  Most likely the PIC restarted, which also takes it back to the default rate
+      ringCommands = RING_SUPPORTS_NONE;
+      EEPROM.write(EEPROM_RING_COMMANDS, RING_SUPPORTS_UNKNOWN);
+      if (ringBaud != RING_BAUD_DEFAULT) {
+        ringBaudSet(RING_BAUD_DEFAULT);
+        EEPROM.write(EEPROM_RING_BAUD, RING_BAUD_UNKNOWN);
+      }
+    }
+  }
+}
+
+bool ringEchoCredit() {
+  return (ringCommands & RING_SUPPORTS_ECHO) == 0 || ringEchoPending < RING_CREDITS;
+}
+
+bool ringQueuePut(byte priority, byte frame[], byte length) {
+  if (ringQueueFree(priority) < length) {
+    return false;
+  }
+
+  for (byte r = 0; r < length; r++) {
+    ringQueue[priority][(ringQueueHead[priority] + ringQueueCount[priority]) % RING_QUEUE_BYTES] = frame[r];
+    ringQueueCount[priority]++;
+  }
+  return true;
+}
+
+bool ringScrubColumn(byte position, byte color) {
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    if (ringFrameGet(ringFrameFront, ring, position) != color) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//  Queues one scrub frame at low priority: the rings at the scrub position that have the
+//  same color as the first ring not scrubbed there yet. Positions where all rings have that
+//  color go in one meter frame.
+bool ringScrubFrame() {
+  if (ringScrubLeft == 0) {
+    return false;
+  }
+  if (ringScrubRings == RING_NONE) {
+    ringScrubRings = RING_HOURS_MINUTES_SECONDS;
+  }
+
+  byte ring = 0;
+  while (bitRead(ringScrubRings, ring) == 0) {
+    ring++;
+  }
+  byte color = ringFrameGet(ringFrameFront, ring, ringScrubPosition);
+
+  byte rings = RING_NONE;
+  for (byte other = ring; other < RING_COUNT; other++) {
+    if (bitRead(ringScrubRings, other) == 1 && ringFrameGet(ringFrameFront, other, ringScrubPosition) == color) {
+      bitSet(rings, other);
+    }
+  }
+
+  byte count = 1;
+  if (rings == RING_HOURS_MINUTES_SECONDS && (ringCommands & RING_SUPPORTS_METER)) {
+    while (count < ringScrubLeft && ((ringCommands & RING_SUPPORTS_WRAP) || ringScrubPosition + count < RING_POSITIONS) &&
+           ringScrubColumn((ringScrubPosition + count) % RING_POSITIONS, color)) {
+      count++;
+    }
+  }
+
+  byte frame[] = { RING_CMD_ON_OFF_LEDS, rings, ringScrubPosition, color, RING_CMD_END, RING_CMD_END };
+  if (count > 1) {
+    frame[0] = RING_CMD_METER_LEDS;
+    frame[3] = (ringScrubPosition + count - 1) % RING_POSITIONS;
+    frame[4] = color;
+  }
+  if (!ringQueuePut(RING_QUEUE_LOW, frame, ringCommandLength(frame[0]))) {
+    return false;
+  }
+
+  ringScrubRings = ringScrubRings & ~rings;
+  if (ringScrubRings == RING_NONE) {
+    ringScrubPosition = (ringScrubPosition + count) % RING_POSITIONS;
+    ringScrubLeft -= count;
+  }
+  return true;
+}
+
+//  Moves one byte to the TX buffer, false when there is nothing to send or, unless wait is
+//  set, no room in the TX buffer or no credit for the next frame.
+bool ringQueueMoveByte(bool wait) {
+  ringEchoReceive();
+  if (!wait && Serial.availableForWrite() == 0) {
+    return false;
+  }
+
+  if (ringQueueFrameLeft == 0) {
+    if (ringQueueCount[RING_QUEUE_HIGH] > 0 && !ringQueueHeld) {
+      ringQueueSending = RING_QUEUE_HIGH;
+    } else if (ringQueueCount[RING_QUEUE_LOW] > 0 || (!wait && !ringQueueHeld && ringEchoCredit() && ringScrubFrame())) {
+      ringQueueSending = RING_QUEUE_LOW;
+    } else {
+      return false;
+    }
+
+    while (!ringEchoCredit()) {
+      if (!wait) {
+        return false;
+      }
+      //  Not delay(), which would come back here through yield()
+      delayMicroseconds(100);
+      ringEchoReceive();
+    }
+
+    byte command = ringQueue[ringQueueSending][ringQueueHead[ringQueueSending]];
+    if (ringCommands & RING_SUPPORTS_ECHO) {
+      if (ringEchoPending == 0) {
+        ringEchoMillis = millis();
+      }
+      ringEchoExpected[ringEchoPending++] = command;
+    }
+    ringQueueFrameLeft = ringCommandLength(command);
+  }
+
+  byte priority = ringQueueSending;
+  Serial.write(ringQueue[priority][ringQueueHead[priority]]);
+  ringQueueHead[priority] = (ringQueueHead[priority] + 1) % RING_QUEUE_BYTES;
+  ringQueueCount[priority]--;
+
+  ringQueueFrameLeft--;
+  return true;
+}
+
+void ringQueuePump() {
+  while (ringQueueMoveByte(false)) {
+  }
+}
+
+//  Waits until every queued frame is in the TX buffer.
+void ringQueueDrain() {
+  while (ringQueueMoveByte(true)) {
+  }
+}
+
+bool ringQueueSubmit(byte priority, byte frame[], byte length) {
+  if (!ringQueuePut(priority, frame, length)) {
+    return false;
+  }
+  ringQueuePump();
+  return true;
+}
+
+//  Queues a frame at high priority, waiting for room if the queue is full.
+void ringQueueSend(byte frame[], byte length) {
+  while (!ringQueueSubmit(RING_QUEUE_HIGH, frame, length)) {
+    ringQueueMoveByte(true);
+  }
+}
+
+//  ====================================================================================
+
+//  Carries out a ring frame on both framebuffers, as the PIC will, for frames sent outside of
+//  ringFrameFlush().
+//
+void ringFrameApply(byte frame[]) {
+  drawnFaceValid = false;
+  byte rings = frame[1];
+  if (frame[0] == RING_CMD_ON_OFF_LEDS) {
+    ringFramePut(ringFrameBack, rings, frame[2], frame[3]);
+    ringFramePut(ringFrameFront, rings, frame[2], frame[3]);
+  } else if (frame[0] == RING_CMD_METER_LEDS) {
+    byte r = frame[2];
+    while (true) {
+      ringFramePut(ringFrameBack, rings, r, frame[4]);
+      ringFramePut(ringFrameFront, rings, r, frame[4]);
+      if (r == frame[3]) {
+        break;
+      }
+      r = (r + 1) % RING_POSITIONS;
+    }
+  } else if (frame[0] == RING_CMD_OFF_LEDS || frame[0] == RING_CMD_OFF_ALL_LEDS) {
+    if (frame[0] == RING_CMD_OFF_ALL_LEDS) {
+      rings = RING_HOURS_MINUTES_SECONDS;
+    }
+    ringFrameErase(ringFrameBack, rings);
+    ringFrameErase(ringFrameFront, rings);
+  }
+}
+
+//  Write circle LED data
+//
+void ledWrite(byte ring, byte number, byte color) {
+  byte frame[] = {
+    RING_CMD_ON_OFF_LEDS,
+    ring,
+    number, //  LED to light (0-59)
+    color,
+    RING_CMD_END
+  };
+  ringFrameApply(frame);
+  ringQueueSend(frame, sizeof(frame));
+}
+
+//  Write one color to circle LEDs startPos to endPos, the only command with 6 bytes. An end
+//  before the start wraps past LED 59.
+//
+void ledWriteMeter(byte ring, byte startPos, byte endPos, byte color) {
+  byte frame[] = {
+    RING_CMD_METER_LEDS,
+    ring,
+    startPos, //  LED to start light (0-59)
+    endPos,   //  LED to end light (0-59)
+    color,
+    RING_CMD_END
+  };
+  ringFrameApply(frame);
+  ringQueueSend(frame, sizeof(frame));
+}
+
+void ledWriteAllInRingOff(byte ring) {
+  byte frame[] = { RING_CMD_OFF_LEDS, ring, RING_CMD_UNUSED, RING_CMD_UNUSED, RING_CMD_END };
+  ringFrameApply(frame);
+  ringQueueSend(frame, sizeof(frame));
 }
 
 void ledWriteAllOff() {
@@ -602,6 +1039,501 @@ void ledWriteAllHoursOff() {
   ledWriteAllInRingOff(RING_HOURS);
 }
 
+//  True when none of the 8 LEDs in byte b of a ring differ between the back buffer and front.
+//
+bool ringFrameByteSame(byte front[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES], byte ring, byte b) {
+  for (byte plane = 0; plane < RING_FRAME_PLANES; plane++) {
+    if (ringFrameBack[ring][plane][b] != front[ring][plane][b]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//  Positions left in the byte of a position, not counting those past LED 59.
+//
+byte ringFrameByteLeft(byte position) {
+  byte left = 8 - (position & 0x07);
+  return left < RING_POSITIONS - position ? left : RING_POSITIONS - position;
+}
+
+//  Marks a LED of the rings of the ring command bits as sent, see ringFrameStartGet().
+//
+void ringFrameMark(byte sent[RING_COUNT][RING_FRAME_BYTES], byte rings, byte position) {
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    if (bitRead(rings, ring) == 1) {
+      bitSet(sent[ring][position >> 3], position & 0x07);
+    }
+  }
+}
+
+//  Color of a LED in the front buffer as it is after moving rings by shifts and turning off
+//  clearRings, or in the back buffer where sent marks the LED as sent already. This lets the
+//  cost of a start be counted without a copy of the front buffer.
+//
+byte ringFrameStartGet(const byte shifts[RING_COUNT], byte clearRings, const byte sent[RING_COUNT][RING_FRAME_BYTES],
+                       byte ring, byte position) {
+  if (bitRead(sent[ring][position >> 3], position & 0x07) == 1) {
+    return ringFrameGet(ringFrameBack, ring, position);
+  }
+  if (bitRead(clearRings, ring) == 1) {
+    return COLOR_BLANK;
+  }
+  return ringFrameGet(ringFrameFront, ring, (position + RING_POSITIONS - shifts[ring]) % RING_POSITIONS);
+}
+
+//  True when none of the 8 LEDs in byte b of a ring differ between the back buffer and the
+//  front buffer after a start, see ringFrameStartGet(). A moved ring is not compared by byte.
+//
+bool ringFrameStartByteSame(const byte shifts[RING_COUNT], byte clearRings, const byte sent[RING_COUNT][RING_FRAME_BYTES],
+                            byte ring, byte b) {
+  if (shifts[ring] != 0) {
+    return false;
+  }
+  for (byte plane = 0; plane < RING_FRAME_PLANES; plane++) {
+    byte front = bitRead(clearRings, ring) == 1 ? 0x00 : ringFrameFront[ring][plane][b];
+    if (((ringFrameBack[ring][plane][b] ^ front) & ~sent[ring][b]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//  Sends the LEDs where the back buffer differs from the front buffer, or unless send is set only
+//  counts the bytes it takes after moving rings by shifts and turning off clearRings. Changed
+//  LEDs go out in runs of one color, one meter command for a run of more than one.
+//
+int ringFrameEmit(const byte shifts[RING_COUNT], byte clearRings, bool send) {
+  byte sent[RING_COUNT][RING_FRAME_BYTES];
+  int bytes = 0;
+  byte ring, other, start, offset, end, last, count, color, rings, position, r;
+  bool same, changed;
+
+  memset(sent, 0, sizeof(sent));
+
+  for (ring = 0; ring < RING_COUNT; ring++) {
+    start = 0;
+    while ((ringCommands & RING_SUPPORTS_WRAP) && start < RING_POSITIONS - 1 &&
+           ringFrameGet(ringFrameBack, ring, start) == ringFrameGet(ringFrameBack, ring, (start + RING_POSITIONS - 1) % RING_POSITIONS)) {
+      start++;
+    }
+
+    offset = 0;
+    while (offset < RING_POSITIONS) {
+      position = (start + offset) % RING_POSITIONS;
+      if (ringFrameStartByteSame(shifts, clearRings, sent, ring, position >> 3)) {
+        offset += ringFrameByteLeft(position);
+        continue;
+      }
+      color = ringFrameGet(ringFrameBack, ring, position);
+      if (color == ringFrameStartGet(shifts, clearRings, sent, ring, position)) {
+        offset++;
+        continue;
+      }
+
+      //  Find the last changed LED of the run starting here, without meter commands every
+      //  LED is a run of its own
+      count = 0;
+      last = offset;
+      for (end = offset; end < RING_POSITIONS && ringFrameGet(ringFrameBack, ring, (start + end) % RING_POSITIONS) == color; end++) {
+        if (ringFrameStartGet(shifts, clearRings, sent, ring, (start + end) % RING_POSITIONS) != color) {
+          count++;
+          last = end;
+        }
+        if ((ringCommands & RING_SUPPORTS_METER) == 0) {
+          break;
+        }
+      }
+
+      rings = RING_NONE;
+      bitSet(rings, ring);
+      for (other = ring + 1; other < RING_COUNT; other++) {
+        same = true;
+        changed = false;
+        for (r = offset; r <= last && same; r++) {
+          same = ringFrameGet(ringFrameBack, other, (start + r) % RING_POSITIONS) == color;
+          changed = changed || ringFrameStartGet(shifts, clearRings, sent, other, (start + r) % RING_POSITIONS) != color;
+        }
+        if (same && changed) {
+          bitSet(rings, other);
+        }
+      }
+
+      //  What does not fit in the queue is sent by a later flush
+      if (send && ringQueueFree(RING_QUEUE_HIGH) < ringCommandLength(count == 1 ? RING_CMD_ON_OFF_LEDS : RING_CMD_METER_LEDS)) {
+        return bytes;
+      }
+
+      //  The back buffer holds these colors already, so the frame only goes to the front
+      //  buffer, not through ringFrameApply() which would forget the face drawn in the back
+      if (count == 1) {
+        bytes += 5;
+        ringFrameMark(sent, rings, position);
+        if (send) {
+          byte frame[] = { RING_CMD_ON_OFF_LEDS, rings, position, color, RING_CMD_END };
+          ringFramePut(ringFrameFront, rings, position, color);
+          ringQueueSend(frame, sizeof(frame));
+        }
+      } else {
+        bytes += 6;
+        for (r = offset; r <= last; r++) {
+          ringFrameMark(sent, rings, (start + r) % RING_POSITIONS);
+          if (send) {
+            ringFramePut(ringFrameFront, rings, (start + r) % RING_POSITIONS, color);
+          }
+        }
+        if (send) {
+          byte frame[] = { RING_CMD_METER_LEDS, rings, position, (byte)((start + last) % RING_POSITIONS), color, RING_CMD_END };
+          ringQueueSend(frame, sizeof(frame));
+        }
+      }
+      offset = last + 1;
+    }
+  }
+  return bytes;
+}
+
+//  Finds how far the LEDs of a ring have moved clockwise from the front buffer to the back
+//  buffer, 0 when moving the ring does not leave fewer LEDs to send or the PIC cannot move.
+//
+//  The first lit LED that changed has to have moved to a changed LED of its color, so only
+//  those distances are tried.
+//
+byte ringFrameFindShift(byte ring) {
+  byte position, target, shift, differ, color;
+  byte bestShift = 0;
+  byte fewest = 0;
+  byte moved = RING_POSITIONS;
+
+  if ((ringCommands & RING_SUPPORTS_MOVE) == 0) {
+    return 0;
+  }
+
+  for (position = 0; position < RING_POSITIONS; position++) {
+    if (ringFrameByteSame(ringFrameFront, ring, position >> 3)) {
+      position += ringFrameByteLeft(position) - 1;
+      continue;
+    }
+    color = ringFrameGet(ringFrameFront, ring, position);
+    if (color != ringFrameGet(ringFrameBack, ring, position)) {
+      fewest++;
+      if (moved == RING_POSITIONS && color != COLOR_BLANK) {
+        moved = position;
+      }
+    }
+  }
+  if (fewest < 2 || moved == RING_POSITIONS) {
+    return 0;
+  }
+
+  color = ringFrameGet(ringFrameFront, ring, moved);
+  for (target = 0; target < RING_POSITIONS; target++) {
+    if (ringFrameByteSame(ringFrameFront, ring, target >> 3)) {
+      target += ringFrameByteLeft(target) - 1;
+      continue;
+    }
+    if (ringFrameGet(ringFrameBack, ring, target) != color || ringFrameGet(ringFrameFront, ring, target) == color) {
+      continue;
+    }
+
+    shift = (target + RING_POSITIONS - moved) % RING_POSITIONS;
+    differ = 0;
+    for (position = 0; position < RING_POSITIONS && differ < fewest; position++) {
+      if (ringFrameGet(ringFrameFront, ring, position) != ringFrameGet(ringFrameBack, ring, (position + shift) % RING_POSITIONS)) {
+        differ++;
+      }
+    }
+    if (differ < fewest) {
+      fewest = differ;
+      bestShift = shift;
+    }
+  }
+  return bestShift;
+}
+
+//  Counts the bytes to send the back buffer after moving rings by shifts, turning off the
+//  cheapest combination of the other changed rings, which is returned in clearRings.
+//
+int ringFrameCount(byte shifts[RING_COUNT], byte changedRings, byte &clearRings) {
+  byte ring, rings;
+  int bytes, fewestBytes = 0;
+
+  //  A move command for each distance, all rings moving as far share one.
+  for (ring = 0; ring < RING_COUNT; ring++) {
+    if (shifts[ring] != 0) {
+      bitClear(changedRings, ring);
+      rings = ring + 1;
+      while (rings < RING_COUNT && shifts[rings] != shifts[ring]) {
+        rings++;
+      }
+      if (rings == RING_COUNT) {
+        fewestBytes += 5;
+      }
+    }
+  }
+
+  clearRings = RING_NONE;
+  fewestBytes += ringFrameEmit(shifts, RING_NONE, false);
+
+  for (rings = RING_SECONDS; rings <= RING_HOURS_MINUTES_SECONDS; rings++) {
+    if ((rings & changedRings) == rings) {
+      bytes = 5 + ringFrameEmit(shifts, rings, false);
+      if (bytes < fewestBytes) {
+        fewestBytes = bytes;
+        clearRings = rings;
+      }
+    }
+  }
+  return fewestBytes;
+}
+
+//  Queues the LEDs where the back buffer differs from the front buffer. When it takes fewer
+//  bytes, rings whose LEDs have moved around are moved with one command first, and some of
+//  the other changed rings are turned off first with one command and redrawn from blank.
+//
+void ringFrameEncode() {
+  byte shifts[RING_COUNT] = { 0, 0, 0 };
+  byte ring, rings, other, shift, clearRings, movedClearRings;
+  byte changedRings = RING_NONE;
+  bool moved = false;
+
+  //  Frames were lost, so nothing is known of the PIC. Start over from blank rings once the
+  //  frames still queued are out.
+  if (ringFrameRedraw && ringQueueIdle()) {
+    byte frame[] = { RING_CMD_OFF_LEDS, RING_HOURS_MINUTES_SECONDS, RING_CMD_UNUSED, RING_CMD_UNUSED, RING_CMD_END };
+    ringFrameErase(ringFrameFront, RING_HOURS_MINUTES_SECONDS);
+    ringQueueSubmit(RING_QUEUE_HIGH, frame, sizeof(frame));
+    ringFrameRedraw = false;
+  }
+
+  for (ring = 0; ring < RING_COUNT; ring++) {
+    if (memcmp(ringFrameBack[ring], ringFrameFront[ring], sizeof(ringFrameFront[ring])) != 0) {
+      bitSet(changedRings, ring);
+      shifts[ring] = ringFrameFindShift(ring);
+      moved = moved || shifts[ring] != 0;
+    }
+  }
+  if (changedRings == RING_NONE) {
+    return;
+  }
+
+  if (moved) {
+    int movedBytes = ringFrameCount(shifts, changedRings, movedClearRings);
+    byte unmoved[RING_COUNT] = { 0, 0, 0 };
+    if (ringFrameCount(unmoved, changedRings, clearRings) <= movedBytes) {
+      memset(shifts, 0, sizeof(shifts));
+    } else {
+      clearRings = movedClearRings;
+    }
+  } else {
+    ringFrameCount(shifts, changedRings, clearRings);
+  }
+
+  for (ring = 0; ring < RING_COUNT; ring++) {
+    shift = shifts[ring];
+    if (shift != 0) {
+      if (ringQueueFree(RING_QUEUE_HIGH) < ringCommandLength(RING_CMD_MOVE_FORWARD)) {
+        return;
+      }
+
+      //  Move all rings going as far at once
+      rings = RING_NONE;
+      for (other = ring; other < RING_COUNT; other++) {
+        if (shifts[other] == shift) {
+          bitSet(rings, other);
+          ringFrameRotate(ringFrameFront, other, shift);
+          shifts[other] = 0;
+        }
+      }
+
+      //  More than half a ring is a shorter move back
+      byte frame[] = { RING_CMD_MOVE_FORWARD, rings, shift, RING_CMD_UNUSED, RING_CMD_END };
+      if (shift > RING_POSITIONS / 2) {
+        frame[0] = RING_CMD_MOVE_REVERSE;
+        frame[2] = RING_POSITIONS - shift;
+      }
+      ringQueueSubmit(RING_QUEUE_HIGH, frame, sizeof(frame));
+    }
+  }
+
+  if (clearRings != RING_NONE) {
+    //  The front buffer changes before the submit pumps, so a scrub frame never sees it stale
+    byte frame[] = { RING_CMD_OFF_LEDS, clearRings, RING_CMD_UNUSED, RING_CMD_UNUSED, RING_CMD_END };
+    if (ringQueueFree(RING_QUEUE_HIGH) < sizeof(frame)) {
+      return;
+    }
+    ringFrameErase(ringFrameFront, clearRings);
+    ringQueueSubmit(RING_QUEUE_HIGH, frame, sizeof(frame));
+  }
+
+  ringFrameEmit(shifts, RING_NONE, true);
+}
+
+//  Sends the changes of the back buffer, unless the next second's frames are held.
+//
+void ringFrameFlush() {
+  if (!ringQueueHeld) {
+    ringFrameEncode();
+  }
+}
+
+//  True when the whole back buffer has been moved to the TX buffer.
+//
+bool ringFrameSent() {
+  return ringQueueIdle() && !ringFrameRedraw && memcmp(ringFrameBack, ringFrameFront, RING_FRAME_SIZE) == 0;
+}
+
+//  Flushes until the whole back buffer is in the TX buffer.
+//
+void ringFrameFlushAndWait() {
+  while (!ringFrameSent()) {
+    ringFrameFlush();
+    ringQueueDrain();
+  }
+}
+
+//  Keeps the ring commands going while delay() waits.
+//
+void yield() {
+  ringFrameFlush();
+  ringQueuePump();
+}
+
+//  ====================================================================================
+
+//  Ring command probe
+//
+//  Finds the optional commands the PIC echoes and keeps them in EEPROM, then moves the link to
+//  the fastest baud rate the PIC keeps up with.
+
+//  Waits for the PIC to echo a command, true if it did before the timeout.
+bool ringWaitForEcho(byte command) {
+  for (byte r = 0; r < RING_PROBE_TIMEOUT; r++) {
+    while (Serial.available() > 0) {
+      if (Serial.read() == command) {
+        return true;
+      }
+    }
+    delay(1);
+  }
+  return false;
+}
+
+//  Sends a command frame on the seconds ring and waits for its echo. The parameter is the
+//  position, the count to move or the baud rate, and the last byte is blank, which also stands
+//  for the unused byte of the move and set baud commands. A meter fills the two LEDs from the
+//  position on, like the shortest run the ring drawing sends. The set baud command takes no ring.
+bool ringProbeCommand(byte command, byte parameter) {
+  byte frame[] = { command, RING_SECONDS, parameter, COLOR_BLANK, RING_CMD_END, RING_CMD_END };
+  if (command == RING_CMD_METER_LEDS) {
+    frame[3] = (parameter + 1) % RING_POSITIONS;
+    frame[4] = COLOR_BLANK;
+  } else if (command == RING_CMD_SET_BAUD) {
+    frame[1] = RING_CMD_UNUSED;
+  }
+
+  ringQueueDrain();
+  while (Serial.available() > 0) {
+    Serial.read();
+  }
+
+  ringQueueSend(frame, ringCommandLength(command));
+  ringQueueDrain();
+  return ringWaitForEcho(command);
+}
+
+//  Switches the link to another baud rate and checks the PIC still echoes there. If not, the
+//  PIC goes back to the previous rate by itself once the trial timeout has passed.
+bool ringBaudTry(byte index) {
+  byte previous = ringBaud;
+  if (ringProbeCommand(RING_CMD_SET_BAUD, index)) {
+    ringBaudSet(index);
+    if (ringProbeCommand(RING_CMD_ON_OFF_LEDS, 0)) {
+      return true;
+    }
+  }
+
+  delay(RING_BAUD_TRIAL_TIMEOUT);
+  ringBaudSet(previous);
+  return false;
+}
+
+//  After a reset of the ATmega alone the PIC still runs at the rate kept in EEPROM, so that
+//  rate is tried before the default one. True if the PIC echoes there.
+bool ringBaudResume() {
+  byte index = EEPROM.read(EEPROM_RING_BAUD);
+  if (index == RING_BAUD_DEFAULT || index > RING_BAUD_FASTEST) {
+    return false;
+  }
+
+  ringBaudSet(index);
+  if (ringProbeCommand(RING_CMD_ON_OFF_LEDS, 0)) {
+    return true;
+  }
+  ringBaudSet(RING_BAUD_DEFAULT);
+  return false;
+}
+
+//  The rate kept in EEPROM is used as it is, and the default rate is only kept there when set
+//  by hand. Otherwise the rate steps up from the default one until the PIC stops answering,
+//  and the fastest rate that worked is kept, or none if no faster rate did.
+void ringNegotiateBaud(byte supported) {
+  if ((supported & RING_SUPPORTS_BAUD) == 0) {
+    return;
+  }
+
+  byte index = EEPROM.read(EEPROM_RING_BAUD);
+  if (index == RING_BAUD_DEFAULT || (index <= RING_BAUD_FASTEST && ringBaudTry(index))) {
+    return;
+  }
+
+  index = RING_BAUD_DEFAULT;
+  while (index < RING_BAUD_FASTEST && ringBaudTry(index + 1)) {
+    index++;
+  }
+  if (index != RING_BAUD_DEFAULT) {
+    EEPROM.write(EEPROM_RING_BAUD, index);
+  } else {
+    EEPROM.write(EEPROM_RING_BAUD, RING_BAUD_UNKNOWN);
+  }
+}
+
+void ringProbeCommands() {
+  bool resumed = ringBaudResume();
+
+  byte supported = EEPROM.read(EEPROM_RING_COMMANDS);
+  if (supported == RING_SUPPORTS_UNKNOWN) {
+    supported = RING_SUPPORTS_NONE;
+    if (!ringProbeCommand(RING_CMD_ON_OFF_LEDS, 0)) {
+      return;
+    }
+
+    //  The frames the ring drawing sends: meters that end before LED 59 and ones that wrap past
+    //  it, and moves that carry a lit LED across it
+    if (ringProbeCommand(RING_CMD_METER_LEDS, RING_POSITIONS - 2)) {
+      supported = supported | RING_SUPPORTS_METER;
+      if (ringProbeCommand(RING_CMD_METER_LEDS, RING_POSITIONS - 1)) {
+        supported = supported | RING_SUPPORTS_WRAP;
+      }
+    }
+    ledWrite(RING_SECONDS, RING_POSITIONS - 1, COLOR_WHITE);
+    if (ringProbeCommand(RING_CMD_MOVE_FORWARD, 1) && ringProbeCommand(RING_CMD_MOVE_REVERSE, 1)) {
+      supported = supported | RING_SUPPORTS_MOVE;
+    }
+    if (ringProbeCommand(RING_CMD_SET_BAUD, ringBaud)) {
+      supported = supported | RING_SUPPORTS_BAUD;
+    }
+    supported = supported | RING_SUPPORTS_ECHO;
+    EEPROM.write(EEPROM_RING_COMMANDS, supported);
+  }
+
+  //  Pacing by the echoes starts once the probe is done
+  if (!resumed) {
+    ringNegotiateBaud(supported);
+  }
+  ringCommands = supported;
+}
+
 //  ====================================================================================
 
 void ledSegmentsStatusWriteByte() {
@@ -869,6 +1801,10 @@ void ledSegmentsDisplayConfig(byte positionAlternate) {
         segmentsDisplayChars[4] = 'd';
       } else if (value == COLOR_HANDS) {
         segmentsDisplayChars[4] = 'h';
+      } else if (value == (COLOR_HANDS | COLOR_SWEEP)) {
+        segmentsDisplayChars[4] = 'H';
+      } else if (value == (COLOR_DOT | COLOR_SWEEP)) {
+        segmentsDisplayChars[4] = 'o';
       } else {
         segmentsDisplayChars[4] = '?';
       }
@@ -955,293 +1891,433 @@ void displayHexAndPause(byte hexValue) {
 
 //  ====================================================================================
 
-void drawHourMarkers(byte steps, byte drawColor) {
-  for (loopMarker = 0; loopMarker < 60; loopMarker = loopMarker + steps) {
-    markers = RING_SECONDS;
-    
-    if (loopMarker == 0) {
-      markers = RING_HOURS_MINUTES_SECONDS;
-    } else if (loopMarker == 15 || loopMarker == 30 || loopMarker == 45) {
-      markers = RING_MINUTES_SECONDS;
-    }
-
-    if ((secondsColor & 0x0f) != COLOR_BLANK) {
-      if (seconds == loopMarker) {
-        if (bitRead(secondsColor, COLOR_BIT_TRACE) == 1) {
-          if (seconds > 0) {
-            // Do not display marker marker if seconds trace is here, except at twelve position
-            markers = markers & RING_HOURS_MINUTES;
-          }
-        } else if (bitRead(secondsColor, COLOR_BIT_DOT) == 1) {
-          // Do not display marker marker if seconds dot is here
-          markers = markers & RING_HOURS_MINUTES;
-        } else if (bitRead(secondsColor, COLOR_BIT_HANDS) == 1) {
-          // Covers whole marker when seconds hand is here
-          markers = RING_NONE;
-        }
-      }
-    }
-  
-    if ((minutesColor & 0x0f) != COLOR_BLANK) {
-      if (minutes == loopMarker) {
-        if (bitRead(minutesColor, COLOR_BIT_TRACE) == 1) {
-          if (minutes > 0) {
-            // Do not display marker if minutes trace is here, except at twelve position
-            markers = markers & RING_HOURS_SECONDS;
-          }
-        } else if (bitRead(minutesColor, COLOR_BIT_DOT) == 1) {
-          // Do not display marker if minutes dot is here
-          markers = markers & RING_HOURS_SECONDS;
-        } else if (bitRead(minutesColor, COLOR_BIT_HANDS) == 1) {
-          // Covers whole marker when minutes hand is here
-          markers = RING_NONE;
-        }
-      }
-    }
+//  Clock face compositor
+//
+//  A face is painted as layers of position masks, each covering the ones below: the bodies of
+//  the traces, the hour markers and the heads of the hands in the order of faceHeadOrder[].
+
+//  Rings covered in the hands style, by the ring of the hand
+const byte faceHandRings[RING_COUNT] = {
+  RING_HOURS_MINUTES_SECONDS,   //  Seconds
+  RING_HOURS_MINUTES_SECONDS,   //  Minutes
+  RING_HOURS_MINUTES            //  Hours
+};
 
-    if ((hoursColor & 0x0f) != COLOR_BLANK) {
-      if (hoursHand == loopMarker) {
-        if (bitRead(hoursColor, COLOR_BIT_TRACE) == 1) {
-          if (hoursHand > 0) {
-            // Do not display marker if hours trace is here, except at twelve position
-            markers = markers & RING_MINUTES_SECONDS;
-          }
-        } else if (bitRead(hoursColor, COLOR_BIT_DOT) == 1) {
-          // Do not display marker if hours dot is here
-          markers = markers & RING_MINUTES_SECONDS;
-        } else if (bitRead(hoursColor, COLOR_BIT_HANDS) == 1) {
-          // Covers marker except seconds when hours hand is here
-          markers = markers & RING_SECONDS;
-        }
-      }
-    }
+//  Rings of the hand heads, bottom first
+const byte faceHeadOrder[RING_COUNT] = { 1, 2, 0 };
+
+//  Hour marker modes
+#define HOUR_MARKER_EVERY     0
+#define HOUR_MARKER_QUARTERS  1
+#define HOUR_MARKER_TWELTH    2
+#define HOUR_MARKER_MODES     3
+#define HOUR_MARKER_NONE      0xff
+
+//  Positions of the hour markers by marker mode and ring, in the layout of a framebuffer plane
+const byte hourMarkerMasks[HOUR_MARKER_MODES][RING_COUNT][RING_FRAME_BYTES] PROGMEM = {
+  { //  Every hour
+    { 0x21, 0x84, 0x10, 0x42, 0x08, 0x21, 0x84, 0x00 },   //  Seconds: 0, 5, 10 ... 55
+    { 0x01, 0x80, 0x00, 0x40, 0x00, 0x20, 0x00, 0x00 },   //  Minutes: 0, 15, 30, 45
+    { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }    //  Hours: 0
+  },
+  { //  Quarters
+    { 0x01, 0x80, 0x00, 0x40, 0x00, 0x20, 0x00, 0x00 },
+    { 0x01, 0x80, 0x00, 0x40, 0x00, 0x20, 0x00, 0x00 },
+    { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }
+  },
+  { //  Twelve only
+    { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }
+  }
+};
 
-    if (markers != RING_NONE) {
-      ledWrite(markers, loopMarker, drawColor);
-    }
+//  Marker mode of a face's markers byte, HOUR_MARKER_NONE when no markers are shown.
+//
+byte hourMarkerMode(byte markers) {
+  if ((markers & 0x0f) == COLOR_BLANK) {
+    return HOUR_MARKER_NONE;
   }
+  if (bitRead(markers, MARKER_BIT_HOUR_EVERY) == 1) {
+    return HOUR_MARKER_EVERY;
+  }
+  if (bitRead(markers, MARKER_BIT_HOUR_QUARTERS) == 1) {
+    return HOUR_MARKER_QUARTERS;
+  }
+  if (bitRead(markers, MARKER_BIT_HOUR_TWELTH) == 1) {
+    return HOUR_MARKER_TWELTH;
+  }
+  return HOUR_MARKER_NONE;
 }
 
-//  Draw markers where no hands are displayed
+//  Rings the head of a hand takes at its position, by the ring of the hand.
 //
-void drawMarkers() {
-  if ((hoursMarkerColor & 0x0f) != COLOR_BLANK) {
-    if (bitRead(hoursMarkerColor, MARKER_BIT_HOUR_EVERY) == 1) {
-      drawHourMarkers(5, hoursMarkerColor & 0x0f);
-    } else if (bitRead(hoursMarkerColor, MARKER_BIT_HOUR_QUARTERS) == 1) {
-      drawHourMarkers(15, hoursMarkerColor & 0x0f);
-    } else if (bitRead(hoursMarkerColor, MARKER_BIT_HOUR_TWELTH) == 1) {
-      drawHourMarkers(60, hoursMarkerColor & 0x0f);
-    }
+byte faceHeadRings(byte ring, byte color, byte position, bool markersShown) {
+  if ((color & 0x0f) == COLOR_BLANK) {
+    return RING_NONE;
   }
+  if (bitRead(color, COLOR_BIT_TRACE) == 1) {
+    return (position > 0 || !markersShown) ? bit(ring) : RING_NONE;
+  }
+  if (bitRead(color, COLOR_BIT_DOT) == 1) {
+    return bit(ring);
+  }
+  if (bitRead(color, COLOR_BIT_HANDS) == 1) {
+    return faceHandRings[ring];
+  }
+  return RING_NONE;
 }
 
-//  ====================================================================================
+//  Positions 0 up to but not including position, in byte b of a framebuffer plane.
+//
+byte faceTraceByte(byte position, byte b) {
+  byte first = b << 3;
+  if (position >= first + 8) {
+    return 0xff;
+  }
+  if (position > first) {
+    return (1 << (position - first)) - 1;
+  }
+  return 0x00;
+}
 
-//  Clear hands (if needed)
+//  Hand positions and the rings of their heads at a time of day, by ring.
 //
-void clearHands() {
-  byte r;
+void faceHands(const byte face[FACE_BYTES], byte hours, byte minutes, byte seconds,
+               byte positions[RING_COUNT], byte headRings[RING_COUNT]) {
+  byte colors[RING_COUNT] = { face[FACE_SECONDS], face[FACE_MINUTES], face[FACE_HOURS] };
+  bool markersShown = hourMarkerMode(face[FACE_MARKERS]) != HOUR_MARKER_NONE;
 
-  //  Check if hours should be cleared
-  if ((hoursColor & 0x0f) != COLOR_BLANK) {
-    if (hoursHand != previousHoursHand) {
-      if (bitRead(hoursColor, COLOR_BIT_TRACE) == 1) {
-        if (hoursHand == 0) {
-          //  Clear the ring if moved to zero position.
-          ledWriteAllInRingOff(RING_HOURS);
-        } else {
-          //  Clear hours down to current time.
-          for (r = previousHoursHand; r > hoursHand; r--) {
-            ledWrite(RING_HOURS, r, COLOR_BLANK);
-          }
-        }
-      } else if (bitRead(hoursColor, COLOR_BIT_DOT) == 1) {
-          //  Clear the previous hours
-          ledWrite(RING_HOURS, previousHoursHand, COLOR_BLANK);
-      } else if (bitRead(hoursColor, COLOR_BIT_HANDS) == 1) {
-          //  Clear the previous hours
-          ledWrite(RING_HOURS_MINUTES, previousHoursHand, COLOR_BLANK);
-      }
-    }
+  positions[0] = seconds;
+  positions[1] = minutes;
+  positions[2] = (hours%12)*5 + minutes/12;
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    headRings[ring] = faceHeadRings(ring, colors[ring], positions[ring], markersShown);
   }
+}
 
-  //  Check if minutes should be cleared
-  if ((minutesColor & 0x0f) != COLOR_BLANK) {
-    if (minutes != previousMinutes) {
-      if (bitRead(minutesColor, COLOR_BIT_TRACE) == 1) {
-        if (minutes == 0) {
-          //  Clear the ring if moved to zero position.
-          ledWriteAllInRingOff(RING_MINUTES);
-        } else {
-          //  Clear minutes down to current time.
-          for (r = previousMinutes; r > minutes; r--) {
-            ledWrite(RING_MINUTES, r, COLOR_BLANK);
-          }
-        }
-      } else if (bitRead(minutesColor, COLOR_BIT_DOT) == 1) {
-          //  Clear the previous minutes
-          ledWrite(RING_MINUTES, previousMinutes, COLOR_BLANK);
-      } else if (bitRead(minutesColor, COLOR_BIT_HANDS) == 1) {
-          //  Clear the previous minutes
-          ledWrite(RING_HOURS_MINUTES_SECONDS, previousMinutes, COLOR_BLANK);
+//  Paints the layers of a face into the positions of a ring set in dirty, one byte of the
+//  planes at a time, and leaves the other positions and bytes alone.
+//
+void renderFaceRing(const byte face[FACE_BYTES], const byte positions[RING_COUNT], const byte headRings[RING_COUNT],
+                    byte ring, const byte dirty[RING_FRAME_BYTES],
+                    byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES]) {
+  byte colors[RING_COUNT] = { face[FACE_SECONDS], face[FACE_MINUTES], face[FACE_HOURS] };
+  byte mode = hourMarkerMode(face[FACE_MARKERS]);
+  bool traced = (colors[ring] & 0x0f) != COLOR_BLANK && bitRead(colors[ring], COLOR_BIT_TRACE) == 1;
+
+  for (byte b = 0; b < RING_FRAME_BYTES; b++) {
+    if (dirty[b] == 0) {
+      continue;
+    }
+
+    //  The colors of the layers, bottom first, and the positions each covers in this byte
+    byte layerColors[RING_COUNT + 2];
+    byte layerMasks[RING_COUNT + 2];
+    byte layers = 0;
+
+    if (traced) {
+      layerColors[layers] = colors[ring];
+      layerMasks[layers++] = faceTraceByte(positions[ring], b);
+    }
+    if (mode != HOUR_MARKER_NONE) {
+      layerColors[layers] = face[FACE_MARKERS];
+      layerMasks[layers++] = pgm_read_byte(&hourMarkerMasks[mode][ring][b]);
+    }
+    for (byte layer = 0; layer < RING_COUNT; layer++) {
+      byte hand = faceHeadOrder[layer];
+      if (bitRead(headRings[hand], ring) == 1 && (positions[hand] >> 3) == b) {
+        layerColors[layers] = colors[hand];
+        layerMasks[layers++] = bit(positions[hand] & 0x07);
       }
     }
-  }
 
-  //  Check if seconds should be cleared
-  if ((secondsColor & 0x0f) != COLOR_BLANK) {
-    if (seconds != previousSeconds) {
-      if (bitRead(secondsColor, COLOR_BIT_TRACE) == 1) {
-        if (seconds == 0) {
-          //  Clear the ring if moved to zero position.
-          ledWriteAllInRingOff(RING_SECONDS);
+    for (byte plane = 0; plane < RING_FRAME_PLANES; plane++) {
+      byte bits = 0x00;
+      for (byte layer = 0; layer < layers; layer++) {
+        if (bitRead(layerColors[layer], plane) == 1) {
+          bits |= layerMasks[layer];
         } else {
-          //  Clear seconds down to current time.
-          for (r = previousSeconds; r > seconds; r--) {
-            ledWrite(RING_SECONDS, r, COLOR_BLANK);
-          }
+          bits &= ~layerMasks[layer];
         }
-      } else if (bitRead(secondsColor, COLOR_BIT_DOT) == 1) {
-          //  Clear the previous seconds when not in trace mode
-          ledWrite(RING_SECONDS, previousSeconds, COLOR_BLANK);
-      } else if (bitRead(secondsColor, COLOR_BIT_HANDS) == 1) {
-          //  Clear the previous seconds when not in trace mode
-          ledWrite(RING_HOURS_MINUTES_SECONDS, previousSeconds, COLOR_BLANK);
       }
+      frame[ring][plane][b] = (frame[ring][plane][b] & ~dirty[b]) | (bits & dirty[b]);
     }
   }
 }
 
-//  Draw the current hands (if needed)
+//  Renders a face at a time of day into a whole frame, layer by layer. Reads and writes
+//  nothing else, so the same face and time always give the same frame.
 //
-void drawHands() {
-  byte r;
+void renderFace(const byte face[FACE_BYTES], byte hours, byte minutes, byte seconds,
+                byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES]) {
+  byte positions[RING_COUNT];
+  byte headRings[RING_COUNT];
+  byte dirty[RING_FRAME_BYTES];
 
-  //  Check if minutes needs to be drawn
-  if ((minutesColor & 0x0f) != COLOR_BLANK) {
-    if (bitRead(minutesColor, COLOR_BIT_TRACE) == 1) {
+  faceHands(face, hours, minutes, seconds, positions, headRings);
+  memset(dirty, 0xff, sizeof(dirty));
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    renderFaceRing(face, positions, headRings, ring, dirty, frame);
+  }
+}
 
-      if (minutes != previousMinutes && (minutes > 0 || (hoursMarkerColor & 0x0f) == COLOR_BLANK)) {
-        //  Fill minutes up to current time, skip 0 for trace.
-        for (r = (minutes <= 1 ? minutes : previousMinutes); r <= minutes; r++) {
-          ledWrite(RING_MINUTES, r, minutesColor & 0x0f);
-        }
+//  Turns a frame renderFace() drew for a face at one time into the frame for another time.
+//  Only the positions a hand head left or reached and the arc between the old and the new end
+//  of a trace are painted again, so the cost follows the size of the change: a tick touches a
+//  few bytes, a trace going back from 59 to 0 or a jump of the clock the bytes it crosses.
+//
+void renderFaceChange(const byte face[FACE_BYTES], byte fromHours, byte fromMinutes, byte fromSeconds,
+                      byte hours, byte minutes, byte seconds,
+                      byte frame[RING_COUNT][RING_FRAME_PLANES][RING_FRAME_BYTES]) {
+  byte fromPositions[RING_COUNT], positions[RING_COUNT];
+  byte fromHeadRings[RING_COUNT], headRings[RING_COUNT];
+  byte colors[RING_COUNT] = { face[FACE_SECONDS], face[FACE_MINUTES], face[FACE_HOURS] };
+
+  faceHands(face, fromHours, fromMinutes, fromSeconds, fromPositions, fromHeadRings);
+  faceHands(face, hours, minutes, seconds, positions, headRings);
+
+  for (byte ring = 0; ring < RING_COUNT; ring++) {
+    byte dirty[RING_FRAME_BYTES] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    for (byte hand = 0; hand < RING_COUNT; hand++) {
+      if (bitRead(fromHeadRings[hand], ring) == 1) {
+        bitSet(dirty[fromPositions[hand] >> 3], fromPositions[hand] & 0x07);
       }
-
-      // Also redraw minutes if second hand has been there previously.
-      if ((secondsColor & 0x0f) != COLOR_BLANK) {
-        if (bitRead(secondsColor, COLOR_BIT_HANDS) == 1) {
-          if (seconds != previousSeconds && minutes >= previousSeconds && previousSeconds > 0) {
-            ledWrite(RING_MINUTES, previousSeconds, minutesColor & 0x0f);
-          }
-        }
+      if (bitRead(headRings[hand], ring) == 1) {
+        bitSet(dirty[positions[hand] >> 3], positions[hand] & 0x07);
       }
+    }
 
-      // Also redraw minutes if hour hand has been there previously.
-      if ((hoursColor & 0x0f) != COLOR_BLANK) {
-        if (bitRead(hoursColor, COLOR_BIT_HANDS) == 1) {
-          if (hoursHand != previousHoursHand && minutes >= previousHoursHand && previousHoursHand > 0) {
-            ledWrite(RING_MINUTES, previousHoursHand, minutesColor & 0x0f);
-          }
-        }
-      }
-    } else if (bitRead(minutesColor, COLOR_BIT_DOT) == 1) {
-      if (minutes != previousMinutes || minutes == previousSeconds || minutes == previousHoursHand) {
-        ledWrite(RING_MINUTES, minutes, minutesColor & 0x0f);
-      }
-    } else if (bitRead(minutesColor, COLOR_BIT_HANDS) == 1) {
-      if (minutes != previousMinutes || minutes == previousSeconds || minutes == previousHoursHand) {
-        ledWrite(RING_HOURS_MINUTES_SECONDS, minutes, minutesColor & 0x0f);
+    //  A trace always starts at 0, so only the arc between its old and new end changes
+    if ((colors[ring] & 0x0f) != COLOR_BLANK && bitRead(colors[ring], COLOR_BIT_TRACE) == 1) {
+      byte low = fromPositions[ring] < positions[ring] ? fromPositions[ring] : positions[ring];
+      byte high = fromPositions[ring] < positions[ring] ? positions[ring] : fromPositions[ring];
+      for (byte b = low >> 3; b <= (high >> 3); b++) {
+        dirty[b] |= faceTraceByte(fromPositions[ring], b) ^ faceTraceByte(positions[ring], b);
       }
     }
+
+    renderFaceRing(face, positions, headRings, ring, dirty, frame);
   }
+}
 
-  //  Check if hours needs to be drawn
-  if ((hoursColor & 0x0f) != COLOR_BLANK) {
-    if (bitRead(hoursColor, COLOR_BIT_TRACE) == 1) {
-      if (hoursHand != previousHoursHand && (hoursHand > 0 || (hoursMarkerColor & 0x0f) == COLOR_BLANK)) {
-        //  Fill hours up to current time, skip 0 for trace.
-        for (r = (hoursHand <= 1 ? hoursHand : previousHoursHand); r <= hoursHand; r++) {
-          ledWrite(RING_HOURS, r, hoursColor & 0x0f);
-        }
-      }
+//  Draws the selected face at the current time into the back buffer. When the back buffer
+//  holds the same face at the previous time, only what changed since is drawn.
+//
+void composeClockFace() {
+  byte face[FACE_BYTES] = { hoursMarkerColor, hoursColor, minutesColor, secondsColor };
+  if (drawnFaceValid && memcmp(face, drawnFace, FACE_BYTES) == 0) {
+    renderFaceChange(face, previousHours, previousMinutes, previousSeconds, hours, minutes, seconds, ringFrameBack);
+  } else {
+    renderFace(face, hours, minutes, seconds, ringFrameBack);
+    memcpy(drawnFace, face, FACE_BYTES);
+    drawnFaceValid = true;
+  }
+}
 
-      // Also redraw hours if minutes hand has been there previously.
-      if ((minutesColor & 0x0f) != COLOR_BLANK) {
-        if (bitRead(minutesColor, COLOR_BIT_HANDS) == 1) {
-          if (minutes != previousMinutes && hoursHand >= previousMinutes && previousMinutes > 0) {
-            ledWrite(RING_HOURS, previousMinutes, hoursColor & 0x0f);
-          }
-        }
-      }
+//  Overlay of the seconds hand for each step of a second: the tail it leaves behind just after
+//  the edge, the head alone, and a blip where it goes next just before the edge. The rings have
+//  only 8 colors, so the tail and blip are lit in the color of the hand rather than faded. The
+//  tail goes out in the frame of the edge itself, see sweepEdge().
+const byte sweepOverlays[SWEEP_STEPS] = { SWEEP_TAIL, SWEEP_NONE, SWEEP_NONE, SWEEP_BLIP };
 
-      // Also redraw hours if seconds hand has been there previously.
-      if ((secondsColor & 0x0f) != COLOR_BLANK) {
-        if (bitRead(secondsColor, COLOR_BIT_HANDS) == 1) {
-          if (seconds != previousSeconds && hoursHand >= previousSeconds && previousSeconds > 0) {
-            ledWrite(RING_HOURS, previousSeconds, hoursColor & 0x0f);
-          }
-        }
-      }
-    } else if (bitRead(hoursColor, COLOR_BIT_DOT) == 1) {
-      if (hoursHand != previousHoursHand || hoursHand == previousMinutes || hoursHand == previousSeconds) {
-        ledWrite(RING_HOURS, hoursHand, hoursColor & 0x0f);
-      }
-    } else if (bitRead(hoursColor, COLOR_BIT_HANDS) == 1) {
-      if (hoursHand != previousHoursHand || hoursHand == previousMinutes || hoursHand == previousSeconds) {
-        ledWrite(RING_HOURS_MINUTES, hoursHand, hoursColor & 0x0f);
-      }
+//  Draws a sweep overlay over the face in the back buffer, which holds the face at the time
+//  given. The tail is one position behind the seconds hand and the blip one ahead, both in the
+//  rings the head takes there. Where neither is set, the face is drawn there again.
+//
+void sweepDraw(byte hours, byte minutes, byte seconds, byte overlay) {
+  byte face[FACE_BYTES] = { hoursMarkerColor, hoursColor, minutesColor, secondsColor };
+  byte sweepPositions[2] = { (byte)((seconds + RING_POSITIONS - 1) % RING_POSITIONS), (byte)((seconds + 1) % RING_POSITIONS) };
+  byte positions[RING_COUNT];
+  byte headRings[RING_COUNT];
+  bool markersShown = hourMarkerMode(face[FACE_MARKERS]) != HOUR_MARKER_NONE;
+
+  faceHands(face, hours, minutes, seconds, positions, headRings);
+  for (byte i = 0; i < 2; i++) {
+    byte position = sweepPositions[i];
+    byte dirty[RING_FRAME_BYTES] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    bitSet(dirty[position >> 3], position & 0x07);
+    for (byte ring = 0; ring < RING_COUNT; ring++) {
+      renderFaceRing(face, positions, headRings, ring, dirty, ringFrameBack);
+    }
+    if (bitRead(overlay, i) == 1) {
+      ringFramePut(ringFrameBack, faceHeadRings(0, secondsColor, position, markersShown), position, secondsColor & 0x0f);
     }
   }
+  sweepShown = overlay;
+}
 
-  //  Check if seconds needs to be drawn
-  if ((secondsColor & 0x0f) != COLOR_BLANK) {
-    if (bitRead(secondsColor, COLOR_BIT_TRACE) == 1) {
-      if (seconds != previousSeconds && (seconds > 0 || (hoursMarkerColor & 0x0f) == COLOR_BLANK)) {
-        //  Fill seconds up to current time, skip 0 for trace.
-        for (r = (seconds <= 1 ? seconds : previousSeconds); r <= seconds; r++) {
-          ledWrite(RING_SECONDS, r, secondsColor & 0x0f);
-        }
-      }
+//  Takes the sweep overlay off the face in the back buffer, before the next time is drawn on it.
+//
+void sweepClear() {
+  if (sweepShown != SWEEP_NONE && drawnFaceValid) {
+    sweepDraw(previousHours, previousMinutes, previousSeconds, SWEEP_NONE);
+  }
+  sweepShown = SWEEP_NONE;
+}
 
-      // Also redraw seconds if minutes hand has been there previously.
-      if ((minutesColor & 0x0f) != COLOR_BLANK) {
-        if (bitRead(minutesColor, COLOR_BIT_HANDS) == 1) {
-          if (minutes != previousMinutes && seconds >= previousMinutes && previousMinutes > 0) {
-            ledWrite(RING_SECONDS, previousMinutes, secondsColor & 0x0f);
-          }
-        }
-      }
-    } else if (bitRead(secondsColor, COLOR_BIT_DOT) == 1) {
-      if (seconds != previousSeconds || seconds == previousMinutes) {
-        ledWrite(RING_SECONDS, seconds, secondsColor & 0x0f);
-      }
-    } else if (bitRead(secondsColor, COLOR_BIT_HANDS) == 1) {
-      if (seconds != previousSeconds || seconds == previousMinutes) {
-        ledWrite(RING_HOURS_MINUTES_SECONDS, seconds, secondsColor & 0x0f);
-      }
+//  Lays the first sweep overlay on a new second in the back buffer, so the edge frame leaves the
+//  tail lit rather than turning it off for the first step to turn it on again.
+//
+void sweepEdge() {
+  if (bitRead(secondsColor, COLOR_BIT_SWEEP) == 1) {
+    sweepDraw(hours, minutes, seconds, sweepOverlays[0]);
+  }
+}
+
+//  Drops the frames held for the next second, before anything else is drawn. The back buffer
+//  holds the next second then, so its tail is taken off and the second shown is drawn back into
+//  it, with its sweep overlay, and the front buffer is what it was before the frames were built.
+//
+void discardNextClockFace() {
+  if (ringQueueHeld) {
+    ringQueueCount[RING_QUEUE_HIGH] = 0;
+    ringQueueHeld = false;
+    if (sweepShown != SWEEP_NONE) {
+      sweepDraw(nextHours, nextMinutes, nextSeconds, SWEEP_NONE);
+    }
+    renderFaceChange(drawnFace, nextHours, nextMinutes, nextSeconds,
+                     previousHours, previousMinutes, previousSeconds, ringFrameBack);
+    if (nextSweep != SWEEP_NONE) {
+      sweepDraw(previousHours, previousMinutes, previousSeconds, nextSweep);
     }
-  }  
-}   
+    memcpy(ringFrameFront, ringFrameBack, RING_FRAME_SIZE);
+  }
+  nextReady = false;
+}
 
 void drawClockFace() {
-    // Calculate position for hours hand (depends on both current hours and minutes)
-    hoursHand = (hours%12)*5 + minutes/12;
-    
-    clearHands();
-    drawHands();
-    drawMarkers();
+    if (nextReady && hours == nextHours && minutes == nextMinutes && seconds == nextSeconds) {
+      //  Drawn ahead, only the held frames have to go out
+      ringQueueHeld = false;
+      ringQueuePump();
+      nextReady = false;
+    } else {
+      discardNextClockFace();
+      sweepClear();
+      composeClockFace();
+      sweepEdge();
+      ringFrameFlush();
+    }
+    nextDrawn = false;
+    sweepMillis = millis();
+    //  The first step went out with the edge
+    sweepStep = 1;
 
-    previousHoursHand = hoursHand;
     previousHours = hours;
     previousMinutes = minutes;
     previousSeconds = seconds;
 }
 
+//  Draws the second after the one shown into the back buffer and builds its frames in the
+//  idle time before its edge, so drawClockFace() only has to let them go. The back buffer
+//  equals the front buffer then, so these are the frames the edge would build, and they are
+//  held in the high priority queue. When they do not fit the queue, or the back buffer does
+//  not hold the face selected, the second is drawn at its edge as usual. The next second gets
+//  its sweep tail as at the edge.
+//
+void drawNextClockFace() {
+  byte face[FACE_BYTES] = { hoursMarkerColor, hoursColor, minutesColor, secondsColor };
+  if (nextDrawn || !ringFrameSent() || !drawnFaceValid || memcmp(face, drawnFace, FACE_BYTES) != 0) {
+    return;
+  }
+  nextDrawn = true;
+
+  nextSeconds = (previousSeconds + 1) % 60;
+  nextMinutes = (previousMinutes + (nextSeconds == 0 ? 1 : 0)) % 60;
+  nextHours = (previousHours + (nextSeconds == 0 && nextMinutes == 0 ? 1 : 0)) % 24;
+
+  byte shownHours = hours;
+  byte shownMinutes = minutes;
+  byte shownSeconds = seconds;
+  hours = nextHours;
+  minutes = nextMinutes;
+  seconds = nextSeconds;
+
+  nextSweep = sweepShown;
+  sweepClear();
+  composeClockFace();
+  sweepEdge();
+  ringQueueHeld = true;
+  ringFrameEncode();
+
+  hours = shownHours;
+  minutes = shownMinutes;
+  seconds = shownSeconds;
+
+  nextReady = memcmp(ringFrameBack, ringFrameFront, RING_FRAME_SIZE) == 0 && ringQueueCount[RING_QUEUE_HIGH] > 0;
+  if (!nextReady) {
+    discardNextClockFace();
+  }
+}
+
+//  Draws the steps of the seconds sweep over the second shown, phase locked to its edge by
+//  sweepMillis. A step goes out only once the link has sent everything before it, so a step
+//  that comes due while the link is still busy is left out for the one after. Returns false
+//  when the face does not sweep or this second's sweep is over, and the next second can be
+//  drawn ahead.
+//
+bool drawSweepStep() {
+  if (bitRead(secondsColor, COLOR_BIT_SWEEP) == 0 || sweepStep >= SWEEP_STEPS || !drawnFaceValid || ringQueueHeld) {
+    return false;
+  }
+
+  unsigned long step = (millis() - sweepMillis) / SWEEP_STEP_MILLIS;
+  if (step < sweepStep || !ringFrameSent()) {
+    return true;
+  }
+  if (step >= SWEEP_STEPS) {
+    step = SWEEP_STEPS - 1;
+  }
+  sweepDraw(previousHours, previousMinutes, previousSeconds, sweepOverlays[step]);
+  sweepStep = step + 1;
+  ringFrameFlush();
+  return true;
+}
+
+//  Sectors a face transition sweeps over, 1 for going straight to the new face. Each step but
+//  the last waits TRANSITION_STEP_DELAY.
+#define TRANSITION_STEPS    6
+
+//  Goes from the face shown to the selected one, at the time shown, in a short clockwise sweep
+//  over the rings. The new face is rendered into the back buffer one sector more at each step,
+//  so only the LEDs that differ are sent, and the face is carried on from the back buffer
+//  afterwards like any other second.
+//
+void drawFaceTransition() {
+  byte face[FACE_BYTES] = { hoursMarkerColor, hoursColor, minutesColor, secondsColor };
+  byte positions[RING_COUNT];
+  byte headRings[RING_COUNT];
+  byte dirty[RING_FRAME_BYTES];
+  byte sector = 0;
+
+  faceHands(face, previousHours, previousMinutes, previousSeconds, positions, headRings);
+  for (byte step = 1; step <= TRANSITION_STEPS; step++) {
+    byte from = sector;
+    sector = step * RING_POSITIONS / TRANSITION_STEPS;
+    for (byte b = 0; b < RING_FRAME_BYTES; b++) {
+      dirty[b] = faceTraceByte(sector, b) & ~faceTraceByte(from, b);
+    }
+    for (byte ring = 0; ring < RING_COUNT; ring++) {
+      renderFaceRing(face, positions, headRings, ring, dirty, ringFrameBack);
+    }
+    ringFrameFlush();
+    if (step < TRANSITION_STEPS) {
+      delay(TRANSITION_STEP_DELAY);
+    }
+  }
+
+  memcpy(drawnFace, face, FACE_BYTES);
+  drawnFaceValid = true;
+  sweepShown = SWEEP_NONE;
+}
+
 //  Forces redrawing the clock face.
 void resetPreviousValues() {
-  previousHoursHand = 0;
+  drawnFaceValid = false;
+  sweepShown = SWEEP_NONE;
+  sweepStep = SWEEP_STEPS;
   previousHours = 0;
   previousMinutes = 0;
   previousSeconds = 0;
@@ -1265,44 +2341,113 @@ void drawDisplayConfiguration()
 
 //  ====================================================================================
 
-void ringAnimation(byte color) {
-  //  Clear clock face with wipe of LEDs
-  ledWrite(RING_HOURS_MINUTES_SECONDS, 0, color);
-  delay(ANIMATION_SHORT_DELAY);
-  
-  for (byte loopCtr=1; loopCtr < 30; loopCtr++) {
-    ledWrite(RING_HOURS_MINUTES_SECONDS, 60-loopCtr, color);
-    ledWrite(RING_HOURS_MINUTES_SECONDS, loopCtr, color);
-    delay(ANIMATION_SHORT_DELAY);
+//  Ring command sequences
+//
+//  Fixed ring animations are put together by the compiler and kept in flash instead of being
+//  drawn at run time. A RingSequence holds its frames back to back in PROGMEM, ended by
+//  RING_SEQUENCE_END, RingSequenceJoin puts two sequences one after the other and
+//  ringSequencePlay() streams the frames into the ring command queue, one frame per step.
+//
+template <byte... Bytes> struct RingSequence {
+  static const byte frames[sizeof...(Bytes) + 1];
+};
+
+template <byte... Bytes> const byte RingSequence<Bytes...>::frames[sizeof...(Bytes) + 1] PROGMEM = {
+  Bytes..., RING_SEQUENCE_END
+};
+
+template <typename First, typename Second> struct RingSequenceJoin;
+
+template <byte... First, byte... Second> struct RingSequenceJoin<RingSequence<First...>, RingSequence<Second...> > {
+  typedef RingSequence<First..., Second...> type;
+};
+
+//  Wipe of all rings to one color, from LED 0 both ways round until LED 30. Each step widens
+//  the wiped arc by one LED on each side and goes out as one meter command wrapping past
+//  LED 59, 185 bytes of flash per color.
+//
+template <byte color, byte step = RING_POSITIONS / 2> struct RingWipe {
+  typedef typename RingSequenceJoin<typename RingWipe<color, step - 1>::type,
+    RingSequence<RING_CMD_METER_LEDS, RING_HOURS_MINUTES_SECONDS, RING_POSITIONS - step, step, color, RING_CMD_END> >::type type;
+};
+
+template <byte color> struct RingWipe<color, 0> {
+  typedef RingSequence<RING_CMD_ON_OFF_LEDS, RING_HOURS_MINUTES_SECONDS, 0, color, RING_CMD_END> type;
+};
+
+template <byte color> struct RingWipe<color, RING_POSITIONS / 2> {
+  typedef typename RingSequenceJoin<typename RingWipe<color, RING_POSITIONS / 2 - 1>::type,
+    RingSequence<RING_CMD_ON_OFF_LEDS, RING_HOURS_MINUTES_SECONDS, RING_POSITIONS / 2, color, RING_CMD_END> >::type type;
+};
+
+//  Wipes kept in flash for the colors the menus use, NULL for the others.
+const byte *ringWipeSequence(byte color) {
+  switch (color) {
+    case COLOR_BLANK: return RingWipe<COLOR_BLANK>::type::frames;
+    case COLOR_RED:   return RingWipe<COLOR_RED>::type::frames;
+    case COLOR_GREEN: return RingWipe<COLOR_GREEN>::type::frames;
+    case COLOR_BLUE:  return RingWipe<COLOR_BLUE>::type::frames;
+    case COLOR_WHITE: return RingWipe<COLOR_WHITE>::type::frames;
   }
-  
-  ledWrite(RING_HOURS_MINUTES_SECONDS, 30, color);
-  delay(ANIMATION_SHORT_DELAY);
+  return NULL;
 }
 
-void ringAnimationUntilNotKeyCombination(byte color, byte keyCombination) {
+//  Streams a sequence from flash into the ring command queue, waiting stepDelay after each
+//  frame. Given a key combination, it stops as soon as other keys are pressed and returns
+//  false.
+//
+bool ringSequencePlay(const byte *sequence, unsigned int stepDelay, byte keyCombination) {
+  byte frame[RING_FRAME_MAX];
+  while ((frame[0] = pgm_read_byte(sequence)) != RING_SEQUENCE_END) {
+    byte length = ringCommandLength(frame[0]);
+    for (byte b = 1; b < length; b++) {
+      frame[b] = pgm_read_byte(sequence + b);
+    }
+    sequence += length;
+
+    ringFrameApply(frame);
+    ringQueueSend(frame, length);
+    delay(stepDelay);
+    if (keyCombination != KEY_PRESSED_NONE) {
+      pressedKeys = readPressedKeys();
+      if (pressedKeys != keyCombination) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
 
-  //  Clear clock face with wipe of LEDs
-  ledWrite(RING_HOURS_MINUTES_SECONDS, 0, color);
-  delay(ANIMATION_KEY_DELAY);
-  pressedKeys = readPressedKeys();
-  if (pressedKeys != keyCombination) {
+//  Wipes all rings to one color. Without meters that wrap past LED 59, or for a color not kept
+//  in flash, the wipe is drawn through the ring framebuffer step by step instead.
+//
+void ringAnimationPlay(byte color, unsigned int stepDelay, byte keyCombination) {
+  const byte *sequence = ringWipeSequence(color);
+  if (sequence != NULL && (ringCommands & RING_SUPPORTS_WRAP)) {
+    ringSequencePlay(sequence, stepDelay, keyCombination);
     return;
   }
-  
-  for (byte loopCtr=1; loopCtr < 30; loopCtr++) {
-    ledWrite(RING_HOURS_MINUTES_SECONDS, 60-loopCtr, color);
-    ledWrite(RING_HOURS_MINUTES_SECONDS, loopCtr, color);
-    delay(ANIMATION_KEY_DELAY);
-    pressedKeys = readPressedKeys();
-    if (pressedKeys != keyCombination) {
-      return;
+
+  for (byte loopCtr=0; loopCtr <= 30; loopCtr++) {
+    ringFrameSet(RING_HOURS_MINUTES_SECONDS, (60-loopCtr) % 60, color);
+    ringFrameSet(RING_HOURS_MINUTES_SECONDS, loopCtr, color);
+    ringFrameFlush();
+    delay(stepDelay);
+    if (keyCombination != KEY_PRESSED_NONE) {
+      pressedKeys = readPressedKeys();
+      if (pressedKeys != keyCombination) {
+        return;
+      }
     }
   }
-  
-  ledWrite(RING_HOURS_MINUTES_SECONDS, 30, color);
-  delay(ANIMATION_KEY_DELAY);
-  pressedKeys = readPressedKeys();
+}
+
+void ringAnimation(byte color) {
+  ringAnimationPlay(color, ANIMATION_SHORT_DELAY, KEY_PRESSED_NONE);
+}
+
+void ringAnimationUntilNotKeyCombination(byte color, byte keyCombination) {
+  ringAnimationPlay(color, ANIMATION_KEY_DELAY, keyCombination);
 }
 
 //  ====================================================================================
@@ -1407,17 +2552,17 @@ void loadSettingsOrFactoryDefaults() {
 
 void loadFaceSettingsOrFactoryDefaults() {
   //  Load in colors saved in Eeprom for the selected clock face
-  hoursMarkerColor = EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 0);
-  hoursColor =       EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 1);
-  minutesColor =     EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 2);
-  secondsColor =     EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 3);
+  hoursMarkerColor = EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_MARKERS);
+  hoursColor =       EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_HOURS);
+  minutesColor =     EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_MINUTES);
+  secondsColor =     EEPROM.read(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_SECONDS);
 
   // Get factory settings if no marker or color was previously set in Eeprom memory.
   if (hoursMarkerColor == 0 && hoursColor == 0 && minutesColor == 0 && secondsColor == 0) {
-    hoursMarkerColor = DEFAULT_FACTORY_COLORS[clockFace][0];
-    hoursColor = DEFAULT_FACTORY_COLORS[clockFace][1]; 
-    minutesColor = DEFAULT_FACTORY_COLORS[clockFace][2];
-    secondsColor = DEFAULT_FACTORY_COLORS[clockFace][3];
+    hoursMarkerColor = DEFAULT_FACTORY_COLORS[clockFace][FACE_MARKERS];
+    hoursColor = DEFAULT_FACTORY_COLORS[clockFace][FACE_HOURS]; 
+    minutesColor = DEFAULT_FACTORY_COLORS[clockFace][FACE_MINUTES];
+    secondsColor = DEFAULT_FACTORY_COLORS[clockFace][FACE_SECONDS];
   }
 }
 
@@ -1427,12 +2572,20 @@ void writeFactorySettingsToEeprom() {
   EEPROM.write(EEPROM_DATE_TIME_AND_COLON, DISPLAY_TIME_AND_DATE | DISPLAY_COLONS_FLASH_EVERY_SECOND);
   EEPROM.write(EEPROM_ALTERNATE_COUNTER, 5);
 
+  //  Probe the PIC again at the next start, from the rate it runs at now
+  EEPROM.write(EEPROM_RING_COMMANDS, RING_SUPPORTS_UNKNOWN);
+  if (ringBaud != RING_BAUD_DEFAULT) {
+    EEPROM.write(EEPROM_RING_BAUD, ringBaud);
+  } else {
+    EEPROM.write(EEPROM_RING_BAUD, RING_BAUD_UNKNOWN);
+  }
+
   // Write default clock faces to Eeprom.
   for (byte r = 0; r < DEFAULT_FACTORY_CLOCK_FACES; r++) {
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + 0, DEFAULT_FACTORY_COLORS[r][0]);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + 1, DEFAULT_FACTORY_COLORS[r][1]);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + 2, DEFAULT_FACTORY_COLORS[r][2]);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + 3, DEFAULT_FACTORY_COLORS[r][3]);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + FACE_MARKERS, DEFAULT_FACTORY_COLORS[r][FACE_MARKERS]);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + FACE_HOURS, DEFAULT_FACTORY_COLORS[r][FACE_HOURS]);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + FACE_MINUTES, DEFAULT_FACTORY_COLORS[r][FACE_MINUTES]);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + r*DEFAULT_CLOCK_FACE_LENGTH + FACE_SECONDS, DEFAULT_FACTORY_COLORS[r][FACE_SECONDS]);
   }
 }
 
@@ -1444,8 +2597,17 @@ void setup() {
   //  I2C interface for the 1307 RTC chip
   Wire.begin();
 
-  //  Enable uart port at desired baud rate 
-  Serial.begin(9600);
+  //  Enable uart port at the PIC's power on baud rate, see ringBaudResume()
+  Serial.begin(ringBaudRate(RING_BAUD_DEFAULT));
+
+#ifdef LATENCY_PROBE_PIN
+  pinMode(LATENCY_PROBE_PIN, OUTPUT);
+  digitalWrite(LATENCY_PROBE_PIN, LOW);
+  Wire.beginTransmission(DS1307_I2C_ADDRESS);
+  Wire.write(DS1307_REG_CONTROL);
+  Wire.write(DS1307_SQW_1HZ);
+  Wire.endTransmission();
+#endif
 
   //  Setup led segements board HT16K33.
   ledSegmentsSetup();
@@ -1465,6 +2627,9 @@ void setup() {
 
   delay(500);
 
+  //  Find the commands the PIC takes
+  ringProbeCommands();
+
   //  Clear led memory buffers in PIC processor
   ledWriteAllOff();
 
@@ -1578,16 +2743,10 @@ void userSelectedStyle() {
   ledSegmentsColons = DISPLAY_COLONS_OFF;
   ledSegmentsDisplayChars();
 
-  ringAnimation(COLOR_WHITE);
-  ringAnimation(COLOR_BLANK);  
-
   loadFaceSettingsOrFactoryDefaults();
 
-  // Force redrawing clock face.
-  resetPreviousValues();
-  
-  //  Clear 7-segments display
-  ledSegmentsClearAll();
+  //  The face number stays on the display until the next second is drawn
+  drawFaceTransition();
 
   waitForReleaseAllButtons();
 }
@@ -1692,6 +2851,10 @@ void userSetFaceColorAndStyle() {
           value = COLOR_TRACE;
         } else if (value == COLOR_TRACE) {
           value = COLOR_DOT;
+        } else if (value == COLOR_DOT && position == SET_POSITION_SECONDS) {
+          value = COLOR_HANDS | COLOR_SWEEP;
+        } else if (value == (COLOR_HANDS | COLOR_SWEEP)) {
+          value = COLOR_DOT | COLOR_SWEEP;
         } else {
           value = COLOR_HANDS;
         }        
@@ -1757,10 +2920,10 @@ void userSetFaceColorAndStyle() {
   }
 
   if (settingsChangedFlag > 0) {
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 0, hoursMarkerColor);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 1, hoursColor);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 2, minutesColor);
-    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + 3, secondsColor);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_MARKERS, hoursMarkerColor);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_HOURS, hoursColor);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_MINUTES, minutesColor);
+    EEPROM.write(EEPROM_CLOCK_FACE_SETTINGS + clockFace*DEFAULT_CLOCK_FACE_LENGTH + FACE_SECONDS, secondsColor);
     ringAnimation(COLOR_GREEN);
   } else {
     ringAnimation(COLOR_BLUE);
@@ -1782,9 +2945,21 @@ void normalMode() {
 
   // Update the clock face every second
   if (seconds != previousSeconds) {
+#ifdef LATENCY_PROBE_PIN
+    digitalWrite(LATENCY_PROBE_PIN, HIGH);
+#endif
     drawClockFace();
     ledSegmentsStatus = MODE_LED_NONE;
     drawNormalLedSegments();
+    ringScrubLeft = RING_SCRUB_POSITIONS;
+#ifdef LATENCY_PROBE_PIN
+    ringFrameFlushAndWait();
+    Serial.flush();
+    digitalWrite(LATENCY_PROBE_PIN, LOW);
+#endif
+  } else if (!drawSweepStep()) {
+    //  Use the rest of the second for the next one
+    drawNextClockFace();
   }
 }
 
@@ -2237,7 +3412,19 @@ void userResetFactoryDefaults() {
    */
 
 void loop() {
-  pressedKeys = readPressedKeys();
+  //  Send what did not fit in the ring command queue last time
+  ringFrameFlush();
+  ringQueuePump();
+
+  //  Only wait for the debounce once a key is down, so the RTC is polled again right away
+  //  while the clock runs
+  pressedKeys = KEY_PRESSED_NONE;
+  if (readKeys() != KEY_PRESSED_NONE) {
+    pressedKeys = readPressedKeys();
+  }
+  if (pressedKeys != KEY_PRESSED_NONE) {
+    discardNextClockFace();
+  }
 
   if (pressedKeys == KEY_PRESSED_1) {
     clockFace--;